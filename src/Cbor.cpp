@@ -0,0 +1,463 @@
+#include "Cbor.hpp"
+
+#include "Utility.hpp"
+#include <algorithm>
+#include <bit>
+#include <cmath>
+
+namespace hk
+{
+
+namespace
+{
+/* Untrusted input can nest arbitrarily deep, don't let it take the stack down. */
+constexpr uint32_t MAX_DEPTH{512};
+/* Counts come from the input too, never pre-allocate more than this up front. */
+constexpr uint64_t MAX_RESERVE{4096};
+
+enum MajorType : uint8_t
+{
+    MAJOR_UNSIGNED = 0,
+    MAJOR_NEGATIVE = 1,
+    MAJOR_BYTES = 2,
+    MAJOR_TEXT = 3,
+    MAJOR_ARRAY = 4,
+    MAJOR_MAP = 5,
+    MAJOR_TAG = 6,
+    MAJOR_SIMPLE = 7
+};
+
+constexpr uint8_t INFO_INDEFINITE{31};
+constexpr uint8_t BREAK_BYTE{0xff};
+
+void encodeHead(const uint8_t major, const uint64_t argument, OutputBuffer& out)
+{
+    const uint8_t majorBits = major << 5;
+    if (argument < 24)
+    {
+        out.append((char)(majorBits | argument));
+    }
+    else if (argument <= 0xff)
+    {
+        out.append((char)(majorBits | 24));
+        out.appendBigEndian(argument, 1);
+    }
+    else if (argument <= 0xffff)
+    {
+        out.append((char)(majorBits | 25));
+        out.appendBigEndian(argument, 2);
+    }
+    else if (argument <= 0xffffffff)
+    {
+        out.append((char)(majorBits | 26));
+        out.appendBigEndian(argument, 4);
+    }
+    else
+    {
+        out.append((char)(majorBits | 27));
+        out.appendBigEndian(argument, 8);
+    }
+}
+
+void encodeObject(const Json::JsonObjectNode& objNode, OutputBuffer& out)
+{
+    encodeHead(MAJOR_MAP, objNode.size(), out);
+    for (const auto& [k, v] : objNode)
+    {
+        encodeHead(MAJOR_TEXT, k.size(), out);
+        out.append(k);
+        Cbor::encodeValue(v, out);
+    }
+}
+
+void encodeList(const Json::JsonListNode& listNode, OutputBuffer& out)
+{
+    encodeHead(MAJOR_ARRAY, listNode.size(), out);
+    for (const auto& v : listNode)
+    {
+        Cbor::encodeValue(v, out);
+    }
+}
+
+/* RFC 8949 Appendix D */
+double decodeHalf(const uint16_t half)
+{
+    const int32_t exponent = (half >> 10) & 0x1f;
+    const int32_t mantissa = half & 0x3ff;
+
+    double value;
+    if (exponent == 0)
+    {
+        value = std::ldexp(mantissa, -24);
+    }
+    else if (exponent != 31)
+    {
+        value = std::ldexp(mantissa + 1024, exponent - 25);
+    }
+    else
+    {
+        value = mantissa == 0 ? INFINITY : NAN;
+    }
+    return (half & 0x8000) ? -value : value;
+}
+
+/* Source is utils::ByteReader for in memory data or utils::StreamReader for streams. */
+template <typename Source> class CborDecoder
+{
+public:
+    explicit CborDecoder(Source& inputSource)
+        : source{inputSource}
+    {}
+
+    std::string decodeValue(Json::JsonFieldValue& value, const uint32_t depth)
+    {
+        if (depth > MAX_DEPTH)
+        {
+            return "CBOR data nested too deep";
+        }
+
+        const uint8_t initial = source.read1();
+        if (source.fail())
+        {
+            return "Unexpected end of CBOR data";
+        }
+
+        const uint8_t major = initial >> 5;
+        const uint8_t info = initial & 0x1f;
+
+        if (major == MAJOR_SIMPLE)
+        {
+            return decodeSimple(info, value);
+        }
+
+        if (info == INFO_INDEFINITE)
+        {
+            if (major == MAJOR_BYTES || major == MAJOR_TEXT)
+            {
+                return decodeIndefiniteString(major, value);
+            }
+            else if (major == MAJOR_ARRAY)
+            {
+                return decodeList(0, true, value, depth);
+            }
+            else if (major == MAJOR_MAP)
+            {
+                return decodeObject(0, true, value, depth);
+            }
+            return "Invalid indefinite length CBOR item";
+        }
+
+        uint64_t argument{0};
+        std::string error = readArgument(info, argument);
+        if (!error.empty())
+        {
+            return error;
+        }
+
+        switch (major)
+        {
+            case MAJOR_UNSIGNED:
+                if (argument > (uint64_t)INT64_MAX)
+                {
+                    return "CBOR unsigned value doesn't fit in int64";
+                }
+                value = (int64_t)argument;
+                return "";
+            case MAJOR_NEGATIVE:
+                if (argument > (uint64_t)INT64_MAX)
+                {
+                    return "CBOR negative value doesn't fit in int64";
+                }
+                value = -1 - (int64_t)argument;
+                return "";
+            case MAJOR_BYTES:
+            case MAJOR_TEXT: {
+                std::string str;
+                error = readString(argument, str);
+                value = std::move(str);
+                return error;
+            }
+            case MAJOR_ARRAY:
+                return decodeList(argument, false, value, depth);
+            case MAJOR_MAP:
+                return decodeObject(argument, false, value, depth);
+            case MAJOR_TAG:
+                /* Semantic tags carry no meaning for a JSON model, use the tagged item as is. */
+                return decodeValue(value, depth + 1);
+        }
+        return "Invalid CBOR major type";
+    }
+
+private:
+    std::string readArgument(const uint8_t info, uint64_t& argument)
+    {
+        if (info < 24)
+        {
+            argument = info;
+        }
+        else if (info == 24)
+        {
+            argument = source.read1();
+        }
+        else if (info == 25)
+        {
+            argument = source.read2();
+        }
+        else if (info == 26)
+        {
+            argument = source.read4();
+        }
+        else if (info == 27)
+        {
+            argument = source.read8();
+        }
+        else
+        {
+            return "Invalid CBOR additional info";
+        }
+
+        if (source.fail())
+        {
+            return "Unexpected end of CBOR data";
+        }
+        return "";
+    }
+
+    std::string decodeSimple(const uint8_t info, Json::JsonFieldValue& value)
+    {
+        switch (info)
+        {
+            case 20:
+                value = false;
+                break;
+            case 21:
+                value = true;
+                break;
+            case 22:
+            case 23:
+                value = Json::JsonNull{};
+                break;
+            case 25:
+                value = decodeHalf(source.read2());
+                break;
+            case 26:
+                value = (double)std::bit_cast<float>(source.read4());
+                break;
+            case 27:
+                value = std::bit_cast<double>(source.read8());
+                break;
+            case INFO_INDEFINITE:
+                return "Unexpected CBOR break";
+            default: {
+                std::string errBuff;
+                sprint(errBuff, "Unsupported CBOR simple value %u", info);
+                return errBuff;
+            }
+        }
+
+        if (source.fail())
+        {
+            return "Unexpected end of CBOR data";
+        }
+        return "";
+    }
+
+    std::string readString(const uint64_t size, std::string& str)
+    {
+        str = source.readString(size);
+        if (source.fail())
+        {
+            return "Unexpected end of CBOR data";
+        }
+        return "";
+    }
+
+    bool isBreakNext()
+    {
+        /* Plain peek() so that EOF (-1) can't be mistaken for the 0xff break byte. */
+        if (source.peek() == BREAK_BYTE)
+        {
+            source.read1();
+            return true;
+        }
+        return false;
+    }
+
+    std::string decodeIndefiniteString(const uint8_t major, Json::JsonFieldValue& value)
+    {
+        /* Chunks must be definite strings of the same major type, terminated by a break. */
+        std::string str;
+        while (!isBreakNext())
+        {
+            const uint8_t initial = source.read1();
+            if (source.fail())
+            {
+                return "Unexpected end of CBOR data";
+            }
+            if ((initial >> 5) != major || (initial & 0x1f) == INFO_INDEFINITE)
+            {
+                return "Invalid chunk inside indefinite length CBOR string";
+            }
+
+            uint64_t size{0};
+            std::string chunk;
+            std::string error = readArgument(initial & 0x1f, size);
+            if (error.empty())
+            {
+                error = readString(size, chunk);
+            }
+            if (!error.empty())
+            {
+                return error;
+            }
+            str += chunk;
+        }
+
+        value = std::move(str);
+        return "";
+    }
+
+    std::string decodeList(const uint64_t count,
+        const bool indefinite,
+        Json::JsonFieldValue& value,
+        const uint32_t depth)
+    {
+        Json::JsonListNode listNode;
+        listNode.reserve(std::min(count, MAX_RESERVE));
+        for (uint64_t i{0}; indefinite ? !isBreakNext() : i < count; i++)
+        {
+            Json::JsonFieldValue item;
+            const std::string error = decodeValue(item, depth + 1);
+            if (!error.empty())
+            {
+                return error;
+            }
+            listNode.emplace_back(std::move(item));
+        }
+
+        value = std::move(listNode);
+        return "";
+    }
+
+    std::string decodeObject(const uint64_t count,
+        const bool indefinite,
+        Json::JsonFieldValue& value,
+        const uint32_t depth)
+    {
+        Json::JsonObjectNode objNode;
+        objNode.reserve(std::min(count, MAX_RESERVE));
+        for (uint64_t i{0}; indefinite ? !isBreakNext() : i < count; i++)
+        {
+            Json::JsonFieldValue key;
+            std::string error = decodeValue(key, depth + 1);
+            if (!error.empty())
+            {
+                return error;
+            }
+            if (!key.isString())
+            {
+                return "CBOR map keys must be text strings";
+            }
+
+            Json::JsonFieldValue item;
+            error = decodeValue(item, depth + 1);
+            if (!error.empty())
+            {
+                return error;
+            }
+            objNode[std::move(key.getString())] = std::move(item);
+        }
+
+        value = std::move(objNode);
+        return "";
+    }
+
+    Source& source;
+};
+template <typename Source> Json::JsonResult decodeRoot(Source& source)
+{
+    Json::JsonFieldValue rootValue;
+    const std::string error = CborDecoder<Source>{source}.decodeValue(rootValue, 0);
+    if (!error.empty())
+    {
+        return {.json = nullptr, .error = error};
+    }
+
+    if (rootValue.isObject())
+    {
+        return {.json = std::make_shared<Json::JsonRootNode>(std::move(rootValue.getObject())), .error = ""};
+    }
+    else if (rootValue.isList())
+    {
+        return {.json = std::make_shared<Json::JsonRootNode>(std::move(rootValue.getList())), .error = ""};
+    }
+    return {.json = nullptr, .error = "CBOR root must be a map or an array"};
+}
+} // namespace
+
+void Cbor::encode(const Json::JsonRootNode& root, OutputBuffer& out)
+{
+    if (std::holds_alternative<Json::JsonObjectNode>(root))
+    {
+        encodeObject(std::get<Json::JsonObjectNode>(root), out);
+    }
+    else if (std::holds_alternative<Json::JsonListNode>(root))
+    {
+        encodeList(std::get<Json::JsonListNode>(root), out);
+    }
+}
+
+void Cbor::encodeValue(const Json::JsonFieldValue& value, OutputBuffer& out)
+{
+    if (value.isString())
+    {
+        encodeHead(MAJOR_TEXT, value.getString().size(), out);
+        out.append(value.getString());
+    }
+    else if (value.isBool())
+    {
+        out.append((char)(value.getBool() ? 0xf5 : 0xf4));
+    }
+    else if (value.isNull())
+    {
+        out.append((char)0xf6);
+    }
+    else if (value.isInt())
+    {
+        const int64_t number = value.getInt();
+        if (number >= 0)
+        {
+            encodeHead(MAJOR_UNSIGNED, number, out);
+        }
+        else
+        {
+            encodeHead(MAJOR_NEGATIVE, (uint64_t)(-1 - number), out);
+        }
+    }
+    else if (value.isDouble())
+    {
+        out.append((char)0xfb);
+        out.appendBigEndian(std::bit_cast<uint64_t>(value.getDouble()), 8);
+    }
+    else if (value.isObject())
+    {
+        encodeObject(value.getObject(), out);
+    }
+    else if (value.isList())
+    {
+        encodeList(value.getList(), out);
+    }
+}
+
+Json::JsonResult Cbor::decode(std::istream& stream)
+{
+    utils::StreamReader source{stream};
+    return decodeRoot(source);
+}
+
+Json::JsonResult Cbor::decode(utils::ByteReader& reader)
+{
+    return decodeRoot(reader);
+}
+
+} // namespace hk
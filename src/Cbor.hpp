@@ -0,0 +1,28 @@
+#pragma once
+
+#include "HkJson.hpp"
+#include "OutputBuffer.hpp"
+#include "Utility.hpp"
+
+#include <istream>
+
+namespace hk
+{
+
+/* CBOR (RFC 8949) <-> DOM conversion, no JSON text in between.
+    - Integers use the shortest head, doubles always go out as float 64, strings as text strings.
+    - Decoding accepts indefinite length items, half/single floats, byte strings (read back as string)
+      and skips over tags. undefined decodes as null. Non text map keys are errors.
+    - decode() consumes exactly one data item, so sequences can be read from the same stream or reader.
+*/
+class Cbor
+{
+public:
+    static void encode(const Json::JsonRootNode& root, OutputBuffer& out);
+    static void encodeValue(const Json::JsonFieldValue& value, OutputBuffer& out);
+
+    static Json::JsonResult decode(std::istream& stream);
+    static Json::JsonResult decode(utils::ByteReader& reader);
+};
+
+} // namespace hk
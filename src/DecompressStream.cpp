@@ -0,0 +1,279 @@
+#include "DecompressStream.hpp"
+
+#include "Utility.hpp"
+#include <algorithm>
+#include <cstring>
+#include <zlib.h>
+
+#ifdef HK_JSON_WITH_ZSTD
+#include <zstd.h>
+#endif
+
+namespace hk
+{
+
+DecompressStreamBuf::~DecompressStreamBuf()
+{
+    releaseDecoder();
+}
+
+std::string DecompressStreamBuf::open(const std::string& path, const Codec newCodec)
+{
+    releaseDecoder();
+
+    file.open(path, std::ios::binary);
+    if (file.fail())
+    {
+        std::string errBuff;
+        sprint(errBuff, "Failed to load: %s", path.c_str());
+        return errBuff;
+    }
+
+    if (newCodec == Codec::GZIP)
+    {
+        z_stream* zs = new z_stream{};
+        /* 15 window bits + 32 lets zlib auto detect gzip or zlib headers */
+        if (inflateInit2(zs, 15 + 32) != Z_OK)
+        {
+            delete zs;
+            return "Failed to initialize zlib inflater";
+        }
+        decoder = zs;
+    }
+    else if (newCodec == Codec::ZSTD)
+    {
+#ifdef HK_JSON_WITH_ZSTD
+        ZSTD_DStream* ds = ZSTD_createDStream();
+        if (ds == nullptr || ZSTD_isError(ZSTD_initDStream(ds)))
+        {
+            ZSTD_freeDStream(ds);
+            return "Failed to initialize zstd decoder";
+        }
+        decoder = ds;
+#else
+        return "zstd support is not compiled in (build with HK_JSON_WITH_ZSTD)";
+#endif
+    }
+
+    codec = newCodec;
+    inBuffer.resize(CHUNK_SIZE);
+    outBuffer.resize(PUTBACK_SIZE + CHUNK_SIZE);
+    inSize = inPos = windowOffset = 0;
+    inputEnded = decoderEnded = false;
+    error.clear();
+    setg(outBuffer.data(), outBuffer.data(), outBuffer.data());
+
+    return "";
+}
+
+const std::string& DecompressStreamBuf::getError() const
+{
+    return error;
+}
+
+DecompressStreamBuf::Codec DecompressStreamBuf::detectCodec(const std::string& path)
+{
+    std::ifstream probe{path, std::ios::binary};
+    uint8_t magic[4]{0};
+    probe.read((char*)magic, 4);
+
+    if (probe.gcount() >= 2 && magic[0] == 0x1f && magic[1] == 0x8b)
+    {
+        return Codec::GZIP;
+    }
+
+    /* zlib header: deflate method with a valid header checksum */
+    if (probe.gcount() >= 2 && (magic[0] & 0x0f) == 0x08 && ((magic[0] << 8) | magic[1]) % 31 == 0)
+    {
+        return Codec::GZIP;
+    }
+
+    if (probe.gcount() == 4 && magic[0] == 0x28 && magic[1] == 0xb5 && magic[2] == 0x2f && magic[3] == 0xfd)
+    {
+        return Codec::ZSTD;
+    }
+
+    return Codec::NONE;
+}
+
+DecompressStreamBuf::int_type DecompressStreamBuf::underflow()
+{
+    if (gptr() < egptr())
+    {
+        return traits_type::to_int_type(*gptr());
+    }
+
+    if (!file.is_open() || decoderEnded)
+    {
+        return traits_type::eof();
+    }
+
+    /* Keep the tail of the previous block around so short seeks backwards still land inside the window. */
+    const uint64_t consumed = gptr() - eback();
+    const uint64_t keep = std::min<uint64_t>(PUTBACK_SIZE, consumed);
+    std::memmove(outBuffer.data(), gptr() - keep, keep);
+    windowOffset += consumed - keep;
+
+    const uint64_t produced = decodeInto(outBuffer.data() + keep, CHUNK_SIZE);
+    setg(outBuffer.data(), outBuffer.data() + keep, outBuffer.data() + keep + produced);
+
+    if (produced == 0)
+    {
+        return traits_type::eof();
+    }
+    return traits_type::to_int_type(*gptr());
+}
+
+DecompressStreamBuf::pos_type DecompressStreamBuf::seekoff(off_type off,
+    std::ios_base::seekdir dir,
+    std::ios_base::openmode which)
+{
+    if (!(which & std::ios_base::in) || dir == std::ios_base::end)
+    {
+        return pos_type(off_type(-1));
+    }
+
+    const int64_t current = windowOffset + (gptr() - eback());
+    const int64_t target = dir == std::ios_base::beg ? off : current + off;
+
+    /* Only positions still inside the decoded window are reachable, the stream can't be rewound. */
+    if (target < (int64_t)windowOffset || target > (int64_t)(windowOffset + (egptr() - eback())))
+    {
+        return pos_type(off_type(-1));
+    }
+
+    setg(eback(), eback() + (target - windowOffset), egptr());
+    return pos_type(target);
+}
+
+DecompressStreamBuf::pos_type DecompressStreamBuf::seekpos(pos_type pos, std::ios_base::openmode which)
+{
+    return seekoff(off_type(pos), std::ios_base::beg, which);
+}
+
+bool DecompressStreamBuf::refillInput()
+{
+    if (inputEnded)
+    {
+        return false;
+    }
+
+    file.read(inBuffer.data(), CHUNK_SIZE);
+    inSize = file.gcount();
+    inPos = 0;
+
+    if (inSize == 0)
+    {
+        inputEnded = true;
+        return false;
+    }
+    return true;
+}
+
+uint64_t DecompressStreamBuf::decodeInto(char* out, const uint64_t capacity)
+{
+    if (codec == Codec::NONE)
+    {
+        /* Plain file, read straight into the window. */
+        file.read(out, capacity);
+        decoderEnded = file.gcount() == 0;
+        return file.gcount();
+    }
+
+    uint64_t produced{0};
+    while (produced == 0 && !decoderEnded)
+    {
+        if (inPos == inSize)
+        {
+            refillInput();
+        }
+
+        bool frameEnded{false};
+        if (codec == Codec::GZIP)
+        {
+            z_stream* zs = (z_stream*)decoder;
+            zs->next_in = (Bytef*)inBuffer.data() + inPos;
+            zs->avail_in = inSize - inPos;
+            zs->next_out = (Bytef*)out + produced;
+            zs->avail_out = capacity - produced;
+
+            const int32_t ret = inflate(zs, Z_NO_FLUSH);
+            inPos = inSize - zs->avail_in;
+            produced = capacity - zs->avail_out;
+
+            if (ret == Z_STREAM_END)
+            {
+                frameEnded = true;
+                inflateReset(zs);
+            }
+            else if (ret != Z_OK && ret != Z_BUF_ERROR)
+            {
+                sprint(error, "Corrupted gzip data: %s", zs->msg ? zs->msg : "unknown zlib error");
+                decoderEnded = true;
+                break;
+            }
+        }
+#ifdef HK_JSON_WITH_ZSTD
+        else if (codec == Codec::ZSTD)
+        {
+            ZSTD_inBuffer zin{inBuffer.data() + inPos, inSize - inPos, 0};
+            ZSTD_outBuffer zout{out + produced, capacity - produced, 0};
+
+            const size_t ret = ZSTD_decompressStream((ZSTD_DStream*)decoder, &zout, &zin);
+            if (ZSTD_isError(ret))
+            {
+                sprint(error, "Corrupted zstd data: %s", ZSTD_getErrorName(ret));
+                decoderEnded = true;
+                break;
+            }
+            inPos += zin.pos;
+            produced += zout.pos;
+            frameEnded = ret == 0;
+        }
+#endif
+
+        /* Concatenated members/frames are decoded back to back, otherwise we're done. */
+        if (frameEnded && inPos == inSize && !refillInput())
+        {
+            decoderEnded = true;
+        }
+        else if (!frameEnded && produced == 0 && inPos == inSize && inputEnded)
+        {
+            error = "Compressed data is truncated";
+            decoderEnded = true;
+        }
+    }
+
+    return produced;
+}
+
+void DecompressStreamBuf::releaseDecoder()
+{
+    if (file.is_open())
+    {
+        file.close();
+    }
+
+    if (decoder == nullptr)
+    {
+        return;
+    }
+
+    if (codec == Codec::GZIP)
+    {
+        z_stream* zs = (z_stream*)decoder;
+        inflateEnd(zs);
+        delete zs;
+    }
+#ifdef HK_JSON_WITH_ZSTD
+    else if (codec == Codec::ZSTD)
+    {
+        ZSTD_freeDStream((ZSTD_DStream*)decoder);
+    }
+#endif
+
+    decoder = nullptr;
+    codec = Codec::NONE;
+}
+
+} // namespace hk
@@ -0,0 +1,80 @@
+#pragma once
+
+#include "ScanStreamBuf.hpp"
+
+#include <cstdint>
+#include <fstream>
+#include <streambuf>
+#include <string>
+#include <vector>
+
+namespace hk
+{
+
+/* Stream buffer that inflates a compressed file block by block while the parser consumes it.
+    - Only one input chunk and one output chunk live in memory at any time, the file is never
+      inflated as a whole.
+    - Codec::NONE reads the file through as it is, so plain files get the same chunked buffer and the parser's
+      in place string scanning (ScanStreamBuf).
+    - Keeps a small putback window so the parser's short seekg(-N, cur) calls keep working.
+    - gzip (and zlib) is always available, zstd only when built with HK_JSON_WITH_ZSTD.
+*/
+class DecompressStreamBuf : public ScanStreamBuf
+{
+public:
+    enum class Codec
+    {
+        NONE,
+        GZIP,
+        ZSTD
+    };
+
+    DecompressStreamBuf() = default;
+    ~DecompressStreamBuf();
+
+    DecompressStreamBuf(const DecompressStreamBuf&) = delete;
+    DecompressStreamBuf& operator=(const DecompressStreamBuf&) = delete;
+
+    /**
+        @brief Open _path_ and prepare the decoder for _codec_. Returns empty string on success.
+    */
+    std::string open(const std::string& path, const Codec codec);
+
+    /**
+        @brief Error encountered while decoding, if any. Empty otherwise.
+    */
+    const std::string& getError() const;
+
+    /**
+        @brief Look at the leading magic bytes of _path_ and tell which codec produced it.
+    */
+    static Codec detectCodec(const std::string& path);
+
+protected:
+    int_type underflow() override;
+    pos_type seekoff(off_type off, std::ios_base::seekdir dir, std::ios_base::openmode which) override;
+    pos_type seekpos(pos_type pos, std::ios_base::openmode which) override;
+
+private:
+    static constexpr uint32_t PUTBACK_SIZE{64};
+    static constexpr uint32_t CHUNK_SIZE{64 * 1024};
+
+    bool refillInput();
+    uint64_t decodeInto(char* out, const uint64_t capacity);
+    void releaseDecoder();
+
+    Codec codec{Codec::NONE};
+    std::ifstream file;
+    std::vector<char> inBuffer;
+    std::vector<char> outBuffer;
+    uint64_t inSize{0};
+    uint64_t inPos{0};
+    bool inputEnded{false};
+    bool decoderEnded{false};
+    /* Absolute decompressed offset of eback() */
+    uint64_t windowOffset{0};
+    void* decoder{nullptr};
+    std::string error;
+};
+
+} // namespace hk
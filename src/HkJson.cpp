@@ -1,28 +1,168 @@
 #include "HkJson.hpp"
 
+#include "DecompressStream.hpp"
+#include "JsonCanonical.hpp"
+#include "JsonDiff.hpp"
+#include "JsonReader.hpp"
+#include "JsonSerializer.hpp"
+#include "JsonSnapshot.hpp"
+#include "OutputBuffer.hpp"
+#include "ScanStreamBuf.hpp"
+#include "SimdScan.hpp"
 #include "Utility.hpp"
+#include <algorithm>
+#include <bit>
+#include <climits>
+#include <cmath>
 #include <memory>
-#include <sstream>
+#include <istream>
 
 namespace hk
 {
+
+namespace
+{
+constexpr uint64_t TAG_NULL{0x6e756c6c00000001};
+constexpr uint64_t TAG_FALSE{0x66616c7365000002};
+constexpr uint64_t TAG_TRUE{0x7472756500000003};
+constexpr uint64_t TAG_NUMBER{0x6e756d6265720004};
+constexpr uint64_t TAG_NUMBER_BITS{0x6269747300000008};
+constexpr uint64_t TAG_STRING{0x7374720000000005};
+constexpr uint64_t TAG_OBJECT{0x6f626a6563740006};
+constexpr uint64_t TAG_LIST{0x6c69737400000007};
+
+/* splitmix64 finalizer */
+uint64_t mix(uint64_t x)
+{
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111eb;
+    return x ^ (x >> 31);
+}
+
+uint64_t hashString(const std::string_view str)
+{
+    return mix(std::hash<std::string_view>{}(str) ^ TAG_STRING);
+}
+
+bool listsEqual(const Json::JsonListNode& lhs, const Json::JsonListNode& rhs)
+{
+    return lhs.size() == rhs.size() &&
+           std::equal(lhs.begin(), lhs.end(), rhs.begin(),
+               [](const Json::JsonFieldValue& lhsValue, const Json::JsonFieldValue& rhsValue)
+               { return Json::valuesEqual(lhsValue, rhsValue); });
+}
+
+bool objectsEqual(const Json::JsonObjectNode& lhs, const Json::JsonObjectNode& rhs)
+{
+    return lhs.size() == rhs.size() && std::all_of(lhs.begin(), lhs.end(),
+                                           [&rhs](const auto& entry)
+                                           {
+                                               const auto it = rhs.find(entry.first);
+                                               return it != rhs.end() && Json::valuesEqual(entry.second, it->second);
+                                           });
+}
+
+/* _number_ as an int64 if it is integral and in range, so ints and doubles compare exactly. 2^63 is exact as a
+   double, and the range check turns NaN away too. */
+bool toExactInt64(const double number, int64_t& integer)
+{
+    if (!(number >= -9223372036854775808.0 && number < 9223372036854775808.0) || number != std::trunc(number))
+    {
+        return false;
+    }
+    integer = (int64_t)number;
+    return true;
+}
+
+uint64_t hashScalar(const Json::JsonFieldValue& value)
+{
+    if (value.isString())
+    {
+        return hashString(value.getString());
+    }
+    else if (value.isInt() || value.isDouble())
+    {
+        /* Integral values hash as int64 whichever way they're stored (1 and 1.0 agree, -0 is 0), so ints past
+           2^53 don't collide through a double. Anything else hashes by its double bits. */
+        int64_t integer{0};
+        if (value.isInt())
+        {
+            integer = value.getInt();
+        }
+        else if (!toExactInt64(value.getDouble(), integer))
+        {
+            return mix(std::bit_cast<uint64_t>(value.getDouble()) ^ TAG_NUMBER ^ TAG_NUMBER_BITS);
+        }
+        return mix((uint64_t)integer ^ TAG_NUMBER);
+    }
+    else if (value.isBool())
+    {
+        return value.getBool() ? TAG_TRUE : TAG_FALSE;
+    }
+    return TAG_NULL;
+}
+
+/* Container hashes out of their children's, _hashChild_ decides where those come from (fresh or memoized). */
+template <typename HashChild> uint64_t combineObject(const Json::JsonObjectNode& objNode, HashChild&& hashChild)
+{
+    /* Entries are summed so iteration order doesn't matter. */
+    uint64_t sum{0};
+    for (const auto& [key, value] : objNode)
+    {
+        sum += mix(hashString(key) ^ std::rotl(hashChild(value), 17));
+    }
+    return mix(sum ^ TAG_OBJECT ^ objNode.size());
+}
+
+template <typename HashChild> uint64_t combineList(const Json::JsonListNode& listNode, HashChild&& hashChild)
+{
+    uint64_t hash{TAG_LIST ^ listNode.size()};
+    for (const Json::JsonFieldValue& element : listNode)
+    {
+        hash = mix(hash + hashChild(element));
+    }
+    return hash;
+}
+} // namespace
+
 Json::JsonResult Json::loadFromFile(const std::string& path)
 {
-    std::ifstream jsonFile{path};
-    if (jsonFile.fail())
+    /* Compressed files are inflated block by block straight into the parser, plain ones go through the same
+       buffer as they are (Codec::NONE) so strings can be scanned in place. */
+    return loadFromCompressedFile(path, DecompressStreamBuf::detectCodec(path));
+}
+
+Json::JsonResult Json::loadFromCompressedFile(const std::string& path, const DecompressStreamBuf::Codec codec)
+{
+    DecompressStreamBuf decompressBuf;
+    const std::string openError = decompressBuf.open(path, codec);
+    if (!openError.empty())
     {
-        std::string errBuff;
-        sprint(errBuff, "Failed to load: %s", path.c_str());
-        return {.json = nullptr, .error = errBuff};
+        return {.json = nullptr, .error = openError};
     }
 
+    std::istream jsonStream{&decompressBuf};
+
     /* Empty file */
-    if (utils::isNextEOF(jsonFile))
+    if (utils::isNextEOF(jsonStream))
     {
+        if (!decompressBuf.getError().empty())
+        {
+            return {.json = nullptr, .error = decompressBuf.getError()};
+        }
         return {.json = std::make_shared<JsonRootNode>(JsonObjectNode{}), .error = ""};
     }
 
-    return parseStream(jsonFile);
+    JsonResult result = parseStream(jsonStream);
+
+    /* A decoding failure truncates the stream, report the real cause rather than the parser's complaint. */
+    if (!decompressBuf.getError().empty())
+    {
+        return {.json = nullptr, .error = decompressBuf.getError()};
+    }
+    return result;
 }
 
 Json::JsonResult Json::loadFromString(const std::string& data)
@@ -33,8 +173,181 @@ Json::JsonResult Json::loadFromString(const std::string& data)
         return {.json = std::make_shared<JsonRootNode>(JsonObjectNode{}), .error = ""};
     }
 
-    std::istringstream inputStringStream(data);
-    return parseStream(inputStringStream);
+    MemoryStreamBuf memoryBuf{data};
+    std::istream inputStream{&memoryBuf};
+    return parseStream(inputStream);
+}
+
+void Json::setUtf8Validation(const bool enabled)
+{
+    utf8Validation = enabled;
+}
+
+Json::ValidationResult Json::validate(const std::string_view buffer, const bool checkUtf8)
+{
+    JsonReader reader{buffer};
+    reader.setUtf8Validation(checkUtf8);
+    if (reader.skipValue() && !reader.isAtEnd())
+    {
+        reader.fail("Unexpected data after the document end");
+    }
+    return {.error = reader.getError(), .offset = reader.getErrorOffset()};
+}
+
+bool Json::valuesEqual(const JsonFieldValue& lhs, const JsonFieldValue& rhs)
+{
+    if ((lhs.isInt() || lhs.isDouble()) && (rhs.isInt() || rhs.isDouble()))
+    {
+        if (lhs.isInt() && rhs.isInt())
+        {
+            return lhs.getInt() == rhs.getInt();
+        }
+        if (lhs.isDouble() && rhs.isDouble())
+        {
+            return lhs.getDouble() == rhs.getDouble();
+        }
+        /* An int only equals a double holding exactly that integer, casting the int to double would round above
+           2^53. */
+        const int64_t integer = lhs.isInt() ? lhs.getInt() : rhs.getInt();
+        const double number = lhs.isInt() ? rhs.getDouble() : lhs.getDouble();
+        int64_t converted{0};
+        return toExactInt64(number, converted) && converted == integer;
+    }
+
+    if (lhs.isNull() || rhs.isNull())
+    {
+        return lhs.isNull() && rhs.isNull();
+    }
+    if (lhs.isBool() || rhs.isBool())
+    {
+        return lhs.isBool() && rhs.isBool() && lhs.getBool() == rhs.getBool();
+    }
+    if (lhs.isString() || rhs.isString())
+    {
+        return lhs.isString() && rhs.isString() && lhs.getString() == rhs.getString();
+    }
+    if (lhs.isList() && rhs.isList())
+    {
+        return listsEqual(lhs.getList(), rhs.getList());
+    }
+    if (lhs.isObject() && rhs.isObject())
+    {
+        return objectsEqual(lhs.getObject(), rhs.getObject());
+    }
+    return false;
+}
+
+bool Json::valuesEqual(const JsonFieldValue& lhs, const JsonRootNode& rhs)
+{
+    if (std::holds_alternative<JsonObjectNode>(rhs))
+    {
+        return lhs.isObject() && objectsEqual(lhs.getObject(), std::get<JsonObjectNode>(rhs));
+    }
+    return lhs.isList() && listsEqual(lhs.getList(), std::get<JsonListNode>(rhs));
+}
+
+uint64_t Json::hashValue(const JsonFieldValue& value)
+{
+    if (value.isObject())
+    {
+        return hashValue(value.getObject());
+    }
+    else if (value.isList())
+    {
+        return hashValue(value.getList());
+    }
+    return hashScalar(value);
+}
+
+uint64_t Json::hashValue(const JsonObjectNode& objNode)
+{
+    return combineObject(objNode, [](const JsonFieldValue& value) { return hashValue(value); });
+}
+
+uint64_t Json::hashValue(const JsonListNode& listNode)
+{
+    return combineList(listNode, [](const JsonFieldValue& value) { return hashValue(value); });
+}
+
+uint64_t Json::hashValue(const JsonRootNode& root)
+{
+    return std::holds_alternative<JsonObjectNode>(root) ? hashValue(std::get<JsonObjectNode>(root))
+                                                        : hashValue(std::get<JsonListNode>(root));
+}
+
+uint64_t Json::HashCache::hash(const JsonFieldValue& value)
+{
+    if (value.isObject())
+    {
+        return hash(value.getObject());
+    }
+    else if (value.isList())
+    {
+        return hash(value.getList());
+    }
+    return hashScalar(value);
+}
+
+uint64_t Json::HashCache::hash(const JsonObjectNode& objNode)
+{
+    const auto it = containers.find(&objNode);
+    if (it != containers.end())
+    {
+        return it->second;
+    }
+
+    const uint64_t computed = combineObject(objNode, [this](const JsonFieldValue& value) { return hash(value); });
+    containers[&objNode] = computed;
+    return computed;
+}
+
+uint64_t Json::HashCache::hash(const JsonListNode& listNode)
+{
+    const auto it = containers.find(&listNode);
+    if (it != containers.end())
+    {
+        return it->second;
+    }
+
+    const uint64_t computed = combineList(listNode, [this](const JsonFieldValue& value) { return hash(value); });
+    containers[&listNode] = computed;
+    return computed;
+}
+
+uint64_t Json::HashCache::hash(const JsonRootNode& root)
+{
+    return std::holds_alternative<JsonObjectNode>(root) ? hash(std::get<JsonObjectNode>(root))
+                                                        : hash(std::get<JsonListNode>(root));
+}
+
+bool Json::HashCache::equal(const JsonFieldValue& lhs, const JsonFieldValue& rhs)
+{
+    if ((lhs.isObject() && rhs.isObject()) || (lhs.isList() && rhs.isList()))
+    {
+        return &lhs == &rhs || hash(lhs) == hash(rhs);
+    }
+    return valuesEqual(lhs, rhs);
+}
+
+void Json::HashCache::clear()
+{
+    containers.clear();
+}
+
+Json::FreezeResult Json::freeze(const JsonRootNode& root)
+{
+    JsonSnapshot::EncodeResult encoded = JsonSnapshot::encode(root);
+    if (!encoded.error.empty())
+    {
+        return {.snapshot = nullptr, .error = encoded.error};
+    }
+    JsonSnapshot::LoadResult loaded = JsonSnapshot::fromBytes(std::move(encoded.bytes));
+    return {.snapshot = std::move(loaded.snapshot), .error = loaded.error};
+}
+
+Json::JsonListNode Json::diff(const JsonRootNode& from, const JsonRootNode& to)
+{
+    return JsonDiff::diff(from, to);
 }
 
 Json::JsonResult Json::parseStream(std::istream& stream, const bool returnEarly)
@@ -73,19 +386,8 @@ Json::JsonResult Json::parseStream(std::istream& stream, const bool returnEarly)
 
         switch (currentChar)
         {
-            /* Dump away any spaces (unless collecting strings) and new lines */
-            case ' ': {
-                if (state == State::GOT_STRING_KEY_VALUE_OPENING_QUOTE ||
-                    state == State::GETTING_STRING_KEY_VALUE_CHARS)
-                {
-                    secondaryAcc += currentChar;
-                }
-                else if (state == State::GOT_BRAKET_STRING_OPENING_QUOTE || state == State::GETTING_BRAKET_STRING_CHARS)
-                {
-                    primaryAcc += currentChar;
-                }
-                break;
-            }
+            /* Dump away any spaces and new lines, strings are read whole by readStringBody */
+            case ' ':
             case '\n': {
                 break;
             }
@@ -246,40 +548,46 @@ Json::JsonResult Json::parseStream(std::istream& stream, const bool returnEarly)
                 }
                 break;
             }
+            /* The opening quote hands over to readStringBody, which consumes up to and including the closing one. */
             case '"': {
                 if (state == State::GOT_CURLY_OPENING_TOKEN)
                 {
-                    JSON_CHANGE_STATE(State::GOT_KEY_NAME_OPENING_QUOTE);
-                }
-                else if (state == State::GETTING_KEY_NAME_CHARS)
-                {
+                    std::string stringError = readStringBody(stream, primaryAcc);
+                    if (!stringError.empty())
+                    {
+                        return {nullptr, stringError};
+                    }
+
                     JSON_CHANGE_STATE(State::GOT_KEY_NAME_CLOSING_QUOTE);
                 }
                 else if (state == State::GOT_DOUBLE_DOT_SEPATATOR)
                 {
-                    JSON_CHANGE_STATE(State::GOT_STRING_KEY_VALUE_OPENING_QUOTE);
-                }
-                // TODO: Quotes are not escaped!
-                else if (state == State::GETTING_STRING_KEY_VALUE_CHARS ||
-                         state == State::GOT_STRING_KEY_VALUE_OPENING_QUOTE)
-                {
-                    JSON_CHANGE_STATE(State::GOT_STRING_KEY_VALUE_CLOSING_QUOTE);
+                    std::string stringError = readStringBody(stream, secondaryAcc);
+                    if (!stringError.empty())
+                    {
+                        return {nullptr, stringError};
+                    }
 
                     std::get<JsonObjectNode>(*currentNode)[primaryAcc] = std::move(secondaryAcc);
                     primaryAcc.clear();
                     secondaryAcc.clear();
+                    JSON_CHANGE_STATE(State::GOT_STRING_KEY_VALUE_CLOSING_QUOTE);
                 }
                 else if (state == State::GOT_BRAKET_OPENING_TOKEN)
                 {
-                    JSON_CHANGE_STATE(State::GOT_BRAKET_STRING_OPENING_QUOTE);
-                }
-                // TODO: Quotes are not escaped!
-                else if (state == State::GETTING_BRAKET_STRING_CHARS || state == State::GOT_BRAKET_STRING_OPENING_QUOTE)
-                {
-                    JSON_CHANGE_STATE(State::GOT_BRAKET_STRING_CLOSING_QUOTE);
+                    std::string stringError = readStringBody(stream, primaryAcc);
+                    if (!stringError.empty())
+                    {
+                        return {nullptr, stringError};
+                    }
 
-                    std::get<JsonListNode>(*currentNode).emplace_back(primaryAcc);
+                    std::get<JsonListNode>(*currentNode).emplace_back(std::move(primaryAcc));
                     primaryAcc.clear();
+                    JSON_CHANGE_STATE(State::GOT_BRAKET_STRING_CLOSING_QUOTE);
+                }
+                else
+                {
+                    return {.json = nullptr, .error = sinkCharAndGetError(currentChar, state)};
                 }
                 break;
             }
@@ -288,14 +596,9 @@ Json::JsonResult Json::parseStream(std::istream& stream, const bool returnEarly)
                 {
                     JSON_CHANGE_STATE(State::GOT_DOUBLE_DOT_SEPATATOR);
                 }
-                else if (state == State::GOT_STRING_KEY_VALUE_OPENING_QUOTE ||
-                         state == State::GETTING_STRING_KEY_VALUE_CHARS)
-                {
-                    secondaryAcc += currentChar;
-                }
-                else if (state == State::GOT_BRAKET_STRING_OPENING_QUOTE || state == State::GETTING_BRAKET_STRING_CHARS)
+                else
                 {
-                    primaryAcc += currentChar;
+                    return {.json = nullptr, .error = sinkCharAndGetError(currentChar, state)};
                 }
                 break;
             }
@@ -358,34 +661,7 @@ Json::JsonResult Json::parseStream(std::istream& stream, const bool returnEarly)
             }
             /* Default non-special chars aggregator */
             default: {
-                if (state == State::GOT_KEY_NAME_OPENING_QUOTE)
-                {
-                    JSON_CHANGE_STATE(State::GETTING_KEY_NAME_CHARS);
-                    primaryAcc += currentChar;
-                }
-                else if (state == State::GETTING_KEY_NAME_CHARS)
-                {
-                    primaryAcc += currentChar;
-                }
-                else if (state == State::GOT_STRING_KEY_VALUE_OPENING_QUOTE)
-                {
-                    JSON_CHANGE_STATE(State::GETTING_STRING_KEY_VALUE_CHARS);
-                    secondaryAcc += currentChar;
-                }
-                else if (state == State::GETTING_STRING_KEY_VALUE_CHARS)
-                {
-                    secondaryAcc += currentChar;
-                }
-                else if (state == State::GOT_BRAKET_STRING_OPENING_QUOTE)
-                {
-                    JSON_CHANGE_STATE(State::GETTING_BRAKET_STRING_CHARS);
-                    primaryAcc += currentChar;
-                }
-                else if (state == State::GETTING_BRAKET_STRING_CHARS)
-                {
-                    primaryAcc += currentChar;
-                }
-                else if (state == State::GOT_DOUBLE_DOT_SEPATATOR || state == State::GOT_BRAKET_OPENING_TOKEN)
+                if (state == State::GOT_DOUBLE_DOT_SEPATATOR || state == State::GOT_BRAKET_OPENING_TOKEN)
                 {
                     if ((currentChar >= '0' && currentChar <= '9') || currentChar == '-')
                     {
@@ -554,128 +830,226 @@ std::string Json::sinkCharAndGetError(const char currentChar, State& state, cons
     return errorStr;
 }
 
-bool Json::isSpecialString(std::istream& stream, const std::string& specialStr)
+std::string Json::readStringBody(std::istream& stream, std::string& out)
 {
-    uint8_t readChars{0};
-    for (const char& ch : specialStr)
+    std::streambuf* buf = stream.rdbuf();
+    ScanStreamBuf* scannable = dynamic_cast<ScanStreamBuf*>(buf);
+    uint64_t segmentStart = out.size();
+
+    while (true)
     {
-        if (utils::read1(stream) != ch)
+        /* Copy the escape free run sitting in the buffer in one go. Streambufs that aren't ours can't be looked
+           into, they are walked one char at a time through the same code. */
+        const int peeked = buf->sgetc();
+        if (peeked == EOF)
         {
-            break;
+            return "Missing closing quote of string";
         }
-        readChars++;
-    }
 
-    if (readChars != specialStr.size())
-    {
-        stream.seekg(-readChars, std::ios::cur);
-        return false;
-    }
-    return true;
-}
-
-void Json::printJson(const JsonRootNode& node)
-{
-    if (std::holds_alternative<JsonObjectNode>(node))
-    {
-        printJsonObject(std::get<JsonObjectNode>(node), 0);
-    }
-    else if (std::holds_alternative<JsonListNode>(node))
-    {
-        printJsonList(std::get<JsonListNode>(node), 0);
-    }
-    printf("\n");
-}
-
-void Json::printJsonObject(const JsonObjectNode& objNode, uint32_t depth)
-{
-    printf("{");
-    const auto& kvMap = objNode;
-    const uint64_t mapSize = kvMap.size();
-    for (uint32_t i{0}; auto& [k, v] : kvMap)
-    {
-        if (v.isString())
+        char single = (char)peeked;
+        const char* next = &single;
+        const char* end = &single + 1;
+        if (scannable != nullptr)
         {
-            printf("\"%s\":\"%s\"", k.c_str(), v.getString().c_str());
+            next = scannable->scanBegin();
+            end = scannable->scanEnd();
         }
-        else if (v.isBool())
+
+        const uint64_t available = std::min<uint64_t>(end - next, INT_MAX);
+        const uint64_t run = simd::findEscapable(next, available);
+        const char stop = run < available ? next[run] : 0;
+        out.append(next, run);
+        if (next == &single)
         {
-            printf("\"%s\":%s", k.c_str(), v.getBool() ? "true" : "false");
+            buf->sbumpc();
         }
-        else if (v.isNull())
+        else
         {
-            printf("\"%s\":null", k.c_str());
+            scannable->consume(run < available ? run + 1 : run);
         }
-        else if (v.isInt())
+
+        if (run == available)
         {
-            printf("\"%s\":%ld", k.c_str(), v.getInt());
+            continue;
         }
-        else if (v.isDouble())
+
+        if (stop != '"' && stop != '\\')
         {
-            printf("\"%s\":%lf", k.c_str(), v.getDouble());
+            std::string errBuff;
+            sprint(errBuff, "Unescaped control character 0x%02x in string", (uint8_t)stop);
+            return errBuff;
         }
-        else if (v.isObject())
+
+        /* Escapes always decode to valid UTF-8, only the raw segment before them needs checking. */
+        const uint64_t segmentSize = out.size() - segmentStart;
+        const uint64_t invalidAt = utf8Validation ? simd::findInvalidUtf8(out.data() + segmentStart, segmentSize)
+                                                  : segmentSize;
+        if (invalidAt != segmentSize)
         {
-            printf("\"%s\":", k.c_str());
-            printJsonObject(v.getObject(), depth + 1);
+            /* The stream sits right after the quote/backslash, walk back over the segment to the bad byte. */
+            const int64_t stopOffset = (int64_t)stream.tellg() - 1;
+            std::string errBuff;
+            sprint(errBuff, "Invalid UTF-8 in string at offset %ld", stopOffset - (int64_t)(segmentSize - invalidAt));
+            return errBuff;
         }
-        else if (v.isList())
+
+        if (stop == '"')
         {
-            printf("\"%s\":", k.c_str());
-            printJsonList(v.getList(), depth + 1);
+            return "";
         }
 
-        i++;
-        if (i != mapSize)
+        const std::string escapeError = readEscape(buf, out);
+        if (!escapeError.empty())
         {
-            printf(",");
+            return escapeError;
         }
+        segmentStart = out.size();
     }
-    printf("}");
 }
 
-void Json::printJsonList(const JsonListNode& objNode, uint32_t depth)
+std::string Json::readEscape(std::streambuf* buf, std::string& out)
 {
-    printf("[");
-    const auto& theList = objNode;
-    const uint64_t mapSize = theList.size();
-    for (uint32_t i{0}; const auto& v : theList)
+    /* High surrogate still waiting for its low half, it turns into U+FFFD if none follows. */
+    int32_t highSurrogate{-1};
+
+    while (true)
     {
-        if (v.isString())
+        const int kind = buf->sbumpc();
+        if (kind == EOF)
+        {
+            return "Missing closing quote of string";
+        }
+
+        const char simple = JsonReader::SIMPLE_ESCAPES[(uint8_t)kind];
+        int32_t unit{-1};
+        if (kind == 'u')
         {
-            printf("\"%s\"", v.getString().c_str());
+            char hex[4];
+            for (char& digit : hex)
+            {
+                const int ch = buf->sbumpc();
+                digit = ch == EOF ? 0 : (char)ch;
+            }
+
+            unit = JsonReader::parseHex4({hex, 4});
+            if (unit < 0)
+            {
+                return "Invalid \\u escape, expected 4 hex digits";
+            }
         }
-        else if (v.isBool())
+        else if (simple == 0)
         {
-            printf("%s", v.getBool() ? "true" : "false");
+            std::string errBuff;
+            sprint(errBuff, "Invalid escape sequence '\\%c' in string", (char)kind);
+            return errBuff;
         }
-        else if (v.isNull())
+
+        if (highSurrogate >= 0 && unit >= 0xdc00 && unit <= 0xdfff)
         {
-            printf("null");
+            JsonReader::appendUtf8(out, 0x10000 + ((highSurrogate - 0xd800) << 10) + (unit - 0xdc00));
+            return "";
         }
-        else if (v.isInt())
+
+        if (highSurrogate >= 0)
         {
-            printf("%ld", v.getInt());
+            JsonReader::appendUtf8(out, 0xfffd);
+            highSurrogate = -1;
         }
-        else if (v.isDouble())
+
+        if (unit >= 0xd800 && unit <= 0xdbff)
         {
-            printf("%lf", v.getDouble());
+            /* Only another escape can complete the pair. */
+            highSurrogate = unit;
+            if (buf->sgetc() == '\\')
+            {
+                buf->sbumpc();
+                continue;
+            }
+            JsonReader::appendUtf8(out, 0xfffd);
         }
-        else if (v.isObject())
+        else if (unit >= 0)
         {
-            printJsonObject(v.getObject(), depth + 1);
+            JsonReader::appendUtf8(out, unit >= 0xdc00 && unit <= 0xdfff ? 0xfffd : unit);
         }
-        else if (v.isList())
+        else
         {
-            printJsonList(v.getList(), depth + 1);
+            out.push_back(simple);
         }
-        i++;
-        if (i != mapSize)
+        return "";
+    }
+}
+
+bool Json::isSpecialString(std::istream& stream, const std::string& specialStr)
+{
+    uint8_t readChars{0};
+    for (const char& ch : specialStr)
+    {
+        if (utils::read1(stream) != ch)
         {
-            printf(",");
+            break;
         }
+        readChars++;
     }
-    printf("]");
+
+    if (readChars != specialStr.size())
+    {
+        stream.seekg(-readChars, std::ios::cur);
+        return false;
+    }
+    return true;
+}
+
+void Json::serialize(const JsonRootNode& node, OutputBuffer& out)
+{
+    JsonSerializer serializer{out};
+    serializer.write(node);
+}
+
+std::string Json::toString(const JsonRootNode& node)
+{
+    std::string result;
+    OutputBuffer out{result};
+    serialize(node, out);
+    return result;
+}
+
+void Json::serializeCanonical(const JsonRootNode& node, OutputBuffer& out)
+{
+    JsonCanonicalSerializer serializer{out};
+    serializer.write(node);
+}
+
+std::string Json::toCanonicalString(const JsonRootNode& node)
+{
+    std::string result;
+    OutputBuffer out{result};
+    serializeCanonical(node, out);
+    return result;
+}
+
+void Json::printJson(const JsonRootNode& node)
+{
+    std::string result;
+    OutputBuffer out{result};
+    serialize(node, out);
+    out.append('\n');
+    fwrite(result.data(), 1, result.size(), stdout);
+}
+
+void Json::printJsonObject(const JsonObjectNode& objNode, uint32_t)
+{
+    std::string result;
+    OutputBuffer out{result};
+    JsonSerializer{out}.writeObject(objNode);
+    fwrite(result.data(), 1, result.size(), stdout);
+}
+
+void Json::printJsonList(const JsonListNode& listNode, uint32_t)
+{
+    std::string result;
+    OutputBuffer out{result};
+    JsonSerializer{out}.writeList(listNode);
+    fwrite(result.data(), 1, result.size(), stdout);
 }
 
 void Json::changeState(State& state, State newState, uint32_t line)
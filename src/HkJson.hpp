@@ -1,8 +1,11 @@
 #pragma once
 
+#include "DecompressStream.hpp"
 #include <cstdint>
+#include <functional>
 #include <memory>
 #include <string>
+#include <string_view>
 #include <unordered_map>
 #include <utility>
 #include <variant>
@@ -11,9 +14,11 @@
 namespace hk
 {
 
+class JsonSnapshot;
+class OutputBuffer;
+
 /* DISCLAIMER:
     - very basic error checks and notifiers
-    - " character is not escaped inside tag values
     - Sure, it can be way more optimized but this wasn't the goal.
     - Except for a bit of back and forth, for all intents and purposes the algorithm is O(N)
       and the data is streamed directly from the file. Small adaptations can be done to read
@@ -227,10 +232,112 @@ public:
         const std::string error;
     };
 
+    struct FreezeResult
+    {
+        std::shared_ptr<const JsonSnapshot> snapshot;
+        const std::string error;
+    };
+
+    struct ValidationResult
+    {
+        /* Static string, nullptr when the buffer is well formed. */
+        const char* error;
+        uint64_t offset;
+    };
+
     JsonResult loadFromFile(const std::string& path);
+    JsonResult loadFromCompressedFile(const std::string& path, const DecompressStreamBuf::Codec codec);
     JsonResult loadFromString(const std::string& data);
     JsonResult parseStream(std::istream& stream, const bool returnEarly = false);
 
+    /**
+        @brief Grammar check only: nothing is materialized and nothing is allocated. Strings are scanned with SIMD
+            and the containers walked by JsonReader. Any RFC 8259 value is accepted as root.
+    */
+    static ValidationResult validate(const std::string_view buffer, const bool checkUtf8 = true);
+
+    /**
+        @brief JSON equality: numbers compare by value (1 == 1.0) and objects regardless of key order.
+    */
+    static bool valuesEqual(const JsonFieldValue& lhs, const JsonFieldValue& rhs);
+    static bool valuesEqual(const JsonFieldValue& lhs, const JsonRootNode& rhs);
+
+    /**
+        @brief Merkle hash of a value: containers combine their children's hashes (objects regardless of key order).
+            Numbers hash by value (1 and 1.0 agree, integers exactly past 2^53), in line with valuesEqual. Always
+            computed from the current content, O(size); use a HashCache to hash the same subtrees repeatedly.
+    */
+    static uint64_t hashValue(const JsonFieldValue& value);
+    static uint64_t hashValue(const JsonObjectNode& objNode);
+    static uint64_t hashValue(const JsonListNode& listNode);
+    static uint64_t hashValue(const JsonRootNode& root);
+
+    /* Opt-in memo of container hashes, for passes that hash or compare the same documents over and over (dedup,
+        memoization, diff).
+        - Hashes are kept by container address, nothing is stored in the nodes themselves.
+        - The documents must not change, move or be freed while the cache knows them: clear() it (or drop it)
+          before editing. Values hashed through hashValue, valuesEqual and std::hash are never affected.
+
+        Json::HashCache hashes;
+        bool same = hashes.equal(lhs, rhs);
+    */
+    class HashCache
+    {
+    public:
+        uint64_t hash(const JsonFieldValue& value);
+        uint64_t hash(const JsonObjectNode& objNode);
+        uint64_t hash(const JsonListNode& listNode);
+        uint64_t hash(const JsonRootNode& root);
+
+        /**
+            @brief Equality through the cached hashes: O(1) once both sides are known. Equal 64 bit hashes count as
+                equal values, use valuesEqual where a collision can't be tolerated.
+        */
+        bool equal(const JsonFieldValue& lhs, const JsonFieldValue& rhs);
+
+        void clear();
+
+    private:
+        std::unordered_map<const void*, uint64_t> containers;
+    };
+
+    /* Exact equality functor for hashed containers, e.g. std::unordered_set<JsonFieldValue, std::hash<...>,
+       ValuesEqual>. */
+    struct ValuesEqual
+    {
+        bool operator()(const JsonFieldValue& lhs, const JsonFieldValue& rhs) const
+        {
+            return valuesEqual(lhs, rhs);
+        }
+    };
+
+    /**
+        @brief Immutable copy of _root_ packed into one contiguous buffer (the JsonSnapshot layout), read through
+            const-only SnapshotValue views. Nothing in it is ever written after freezing, so any number of threads
+            can read it at the same time without locks. Fails (null snapshot, reason in error) if a string, list or
+            object is too big for the snapshot layout.
+    */
+    static FreezeResult freeze(const JsonRootNode& root);
+
+    /**
+        @brief RFC 6902 patch turning _from_ into _to_ (see JsonDiff), ready for JsonPatch::apply.
+    */
+    static JsonListNode diff(const JsonRootNode& from, const JsonRootNode& to);
+
+    /**
+        @brief String keys/values are checked to be valid UTF-8 (SIMD, as each string closes) unless disabled here.
+    */
+    void setUtf8Validation(const bool enabled);
+
+    /* Compact serialization into a memory buffer, caller's string or fd. See OutputBuffer. */
+    void serialize(const JsonRootNode& node, OutputBuffer& out);
+    std::string toString(const JsonRootNode& node);
+
+    /* RFC 8785 canonical form (sorted keys, ECMAScript numbers), byte identical for equal documents. See
+       JsonCanonicalSerializer. */
+    void serializeCanonical(const JsonRootNode& node, OutputBuffer& out);
+    std::string toCanonicalString(const JsonRootNode& node);
+
     void printJson(const JsonRootNode& node);
     void printJsonObject(const JsonObjectNode& objNode, uint32_t depth = 0);
     void printJsonList(const JsonListNode& objNode, uint32_t depth = 0);
@@ -288,9 +395,29 @@ private:
     };
 
     std::string sinkCharAndGetError(const char currentChar, State& currentState, const bool fileEnded = false);
+    std::string readStringBody(std::istream& stream, std::string& out);
+    std::string readEscape(std::streambuf* buf, std::string& out);
     bool isSpecialString(std::istream& stream, const std::string& specialStr);
     void changeState(State& state, State newState, uint32_t line);
     std::string getStateString(const State& state);
+
+    bool utf8Validation{true};
 }; // namespace hk
 
-} // namespace hk
\ No newline at end of file
+} // namespace hk
+
+template <> struct std::hash<hk::Json::JsonFieldValue>
+{
+    size_t operator()(const hk::Json::JsonFieldValue& value) const
+    {
+        return hk::Json::hashValue(value);
+    }
+};
+
+template <> struct std::hash<hk::Json::JsonRootNode>
+{
+    size_t operator()(const hk::Json::JsonRootNode& root) const
+    {
+        return hk::Json::hashValue(root);
+    }
+};
@@ -0,0 +1,542 @@
+#pragma once
+
+#include "HkJson.hpp"
+#include "JsonReader.hpp"
+#include "JsonWriter.hpp"
+#include "OutputBuffer.hpp"
+
+#include <array>
+#include <bit>
+#include <cstring>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace hk
+{
+
+/* Declarative binding between C++ structs and JSON objects.
+    - HK_JSON_BIND(Type, member...) at global scope maps each member to a key of the same name.
+      For other key names specialize JsonBinding<Type> by hand with hk::jsonField("key", &Type::member).
+    - JsonBind::read fills the struct straight from the token stream, no DOM is built.
+      Keys are dispatched through a perfect hash generated at compile time from the member names.
+    - JsonBind::write/toString serialize from the same description through JsonWriter.
+    - Supported members: bool, integers, floating point, std::string, std::optional<T>, std::vector<T>,
+      other bound structs and Json::JsonFieldValue (anything goes, parsed into a DOM value).
+    - Keys missing from the input leave the member untouched, unknown keys are skipped.
+    - Key order is predicted from the binding, so documents written in declaration order only cost one memcmp
+      per key. readOrFallback drops to a generic DOM parse when the document doesn't have the declared shape.
+
+    struct Product { int64_t id; std::string name; std::vector<std::string> tags; };
+    HK_JSON_BIND(Product, id, name, tags)
+
+    Product product;
+    std::string error = hk::JsonBind::read(text, product);
+*/
+template <typename T> struct JsonBinding;
+
+template <typename Class, typename Member> struct JsonField
+{
+    using MemberType = Member;
+
+    std::string_view key;
+    Member Class::*member;
+};
+
+template <typename Class, typename Member>
+constexpr JsonField<Class, Member> jsonField(const std::string_view key, Member Class::*member)
+{
+    return {key, member};
+}
+
+/* DEFINE REGION */
+#define HK_JSON_PARENS ()
+#define HK_JSON_EXPAND(...) HK_JSON_EXPAND4(HK_JSON_EXPAND4(HK_JSON_EXPAND4(HK_JSON_EXPAND4(__VA_ARGS__))))
+#define HK_JSON_EXPAND4(...) HK_JSON_EXPAND3(HK_JSON_EXPAND3(HK_JSON_EXPAND3(HK_JSON_EXPAND3(__VA_ARGS__))))
+#define HK_JSON_EXPAND3(...) HK_JSON_EXPAND2(HK_JSON_EXPAND2(HK_JSON_EXPAND2(HK_JSON_EXPAND2(__VA_ARGS__))))
+#define HK_JSON_EXPAND2(...) HK_JSON_EXPAND1(HK_JSON_EXPAND1(HK_JSON_EXPAND1(HK_JSON_EXPAND1(__VA_ARGS__))))
+#define HK_JSON_EXPAND1(...) __VA_ARGS__
+
+#define HK_JSON_FOR_EACH(macro, type, ...) __VA_OPT__(HK_JSON_EXPAND(HK_JSON_FOR_EACH_HELPER(macro, type, __VA_ARGS__)))
+#define HK_JSON_FOR_EACH_HELPER(macro, type, first, ...)                                                               \
+    macro(type, first) __VA_OPT__(, HK_JSON_FOR_EACH_AGAIN HK_JSON_PARENS(macro, type, __VA_ARGS__))
+#define HK_JSON_FOR_EACH_AGAIN() HK_JSON_FOR_EACH_HELPER
+
+#define HK_JSON_FIELD_OF(type, member) ::hk::jsonField(#member, &type::member)
+
+#define HK_JSON_BIND(type, ...)                                                                                        \
+    template <> struct hk::JsonBinding<type>                                                                           \
+    {                                                                                                                  \
+        static constexpr auto fields = std::make_tuple(HK_JSON_FOR_EACH(HK_JSON_FIELD_OF, type, __VA_ARGS__));        \
+    };
+/* DEFINE REGION END */
+
+template <typename T, typename = void> struct IsJsonBound : std::false_type
+{};
+
+template <typename T> struct IsJsonBound<T, std::void_t<decltype(JsonBinding<T>::fields)>> : std::true_type
+{};
+
+template <typename T> struct IsStdVector : std::false_type
+{};
+
+template <typename T, typename A> struct IsStdVector<std::vector<T, A>> : std::true_type
+{};
+
+template <typename T> struct IsStdOptional : std::false_type
+{};
+
+template <typename T> struct IsStdOptional<std::optional<T>> : std::true_type
+{};
+
+/* Compile time perfect hash from a bound struct's keys to its field indices. */
+template <typename T> class JsonKeyIndex
+{
+public:
+    static constexpr uint64_t FIELD_COUNT = std::tuple_size_v<std::remove_cvref_t<decltype(JsonBinding<T>::fields)>>;
+
+    static constexpr std::array<std::string_view, FIELD_COUNT> KEYS = []()
+    {
+        std::array<std::string_view, FIELD_COUNT> keys{};
+        std::apply([&keys](const auto&... field)
+        {
+            uint64_t i{0};
+            ((keys[i++] = field.key), ...);
+        }, JsonBinding<T>::fields);
+        return keys;
+    }();
+
+    /* 4x more slots than keys keeps the seed search short even for wide structs. */
+    static constexpr uint64_t TABLE_SIZE = std::bit_ceil(FIELD_COUNT * 4 < 4 ? 4 : FIELD_COUNT * 4);
+
+    static constexpr uint64_t baseHash(const std::string_view key)
+    {
+        uint64_t hash{14695981039346656037ull};
+        for (const char ch : key)
+        {
+            hash = (hash ^ (uint8_t)ch) * 1099511628211ull;
+        }
+        return hash;
+    }
+
+    static constexpr uint64_t slotOf(const uint64_t base, const uint64_t seed)
+    {
+        uint64_t mixed = (base ^ seed) * 0x9e3779b97f4a7c15ull;
+        return (mixed >> 32) & (TABLE_SIZE - 1);
+    }
+
+    static constexpr uint64_t SEED = []()
+    {
+        for (uint64_t i{0}; i < FIELD_COUNT; i++)
+        {
+            for (uint64_t j{i + 1}; j < FIELD_COUNT; j++)
+            {
+                if (KEYS[i] == KEYS[j])
+                {
+                    throw "HK_JSON_BIND: duplicate JSON key in binding";
+                }
+            }
+        }
+
+        for (uint64_t seed{0};; seed++)
+        {
+            std::array<bool, TABLE_SIZE> used{};
+            bool collision{false};
+            for (uint64_t i{0}; i < FIELD_COUNT && !collision; i++)
+            {
+                const uint64_t slot = slotOf(baseHash(KEYS[i]), seed);
+                collision = used[slot];
+                used[slot] = true;
+            }
+            if (!collision)
+            {
+                return seed;
+            }
+        }
+    }();
+
+    /* Slot -> field index + 1, 0 marks an empty slot. */
+    static constexpr std::array<uint32_t, TABLE_SIZE> TABLE = []()
+    {
+        std::array<uint32_t, TABLE_SIZE> table{};
+        for (uint64_t i{0}; i < FIELD_COUNT; i++)
+        {
+            table[slotOf(baseHash(KEYS[i]), SEED)] = i + 1;
+        }
+        return table;
+    }();
+
+    /**
+        @brief Field index bound to _key_, -1 if the struct has no such key.
+    */
+    static constexpr int32_t find(const std::string_view key)
+    {
+        const int32_t index = (int32_t)TABLE[slotOf(baseHash(key), SEED)] - 1;
+        return (index >= 0 && KEYS[index] == key) ? index : -1;
+    }
+};
+
+class JsonBind
+{
+public:
+    /**
+        @brief Parse _text_ straight into _out_. Returns empty string on success, error with byte offset otherwise.
+    */
+    template <typename T> static std::string read(const std::string_view text, T& out)
+    {
+        JsonReader reader{text};
+        if (readValue(reader, out, 0) && !reader.isAtEnd())
+        {
+            reader.fail("Unexpected data after the document end");
+        }
+        return reader.describeError();
+    }
+
+    /**
+        @brief Try the specialized parser for T first. If _text_ doesn't have the declared shape, parse it
+            generically into _fallback_ instead. Returns empty string when one of the two succeeded,
+            _fallback_ tells which (nullopt when _out_ was filled).
+    */
+    template <typename T>
+    static std::string readOrFallback(
+        const std::string_view text, T& out, std::optional<Json::JsonFieldValue>& fallback)
+    {
+        fallback.reset();
+        JsonReader reader{text};
+        if (readValue(reader, out, 0) && reader.isAtEnd())
+        {
+            return "";
+        }
+
+        JsonReader genericReader{text};
+        if (readFieldValue(genericReader, fallback.emplace(), 0) && !genericReader.isAtEnd())
+        {
+            genericReader.fail("Unexpected data after the document end");
+        }
+        return genericReader.describeError();
+    }
+
+    template <typename T> static void write(const T& value, JsonWriter& writer)
+    {
+        writeValue(value, writer);
+    }
+
+    template <typename T> static std::string toString(const T& value)
+    {
+        std::string result;
+        OutputBuffer out{result};
+        JsonWriter writer{out};
+        writeValue(value, writer);
+        return result;
+    }
+
+    /**
+        @brief Read the next value from _reader_ into _out_, whatever its bound type.
+    */
+    template <typename T> static bool readValue(JsonReader& reader, T& out, const uint32_t depth)
+    {
+        if (depth > JsonReader::MAX_DEPTH)
+        {
+            return reader.fail("Document nested too deep");
+        }
+
+        if constexpr (std::is_same_v<T, bool>)
+        {
+            const char next = reader.peekToken();
+            out = next == 't';
+            return next == 't' ? reader.readLiteral("true") : reader.readLiteral("false");
+        }
+        else if constexpr (std::is_integral_v<T>)
+        {
+            std::string_view raw;
+            bool isInteger{false};
+            int64_t number{0};
+            if (!reader.readNumber(raw, isInteger))
+            {
+                return false;
+            }
+            if (!isInteger || !JsonReader::toInt64(raw, number) || !std::in_range<T>(number))
+            {
+                return reader.fail("Number doesn't fit the bound integer member");
+            }
+            out = (T)number;
+            return true;
+        }
+        else if constexpr (std::is_floating_point_v<T>)
+        {
+            std::string_view raw;
+            bool isInteger{false};
+            if (!reader.readNumber(raw, isInteger))
+            {
+                return false;
+            }
+            out = (T)JsonReader::toDouble(raw);
+            return true;
+        }
+        else if constexpr (std::is_same_v<T, std::string>)
+        {
+            return reader.readString(out);
+        }
+        else if constexpr (IsStdOptional<T>::value)
+        {
+            if (reader.peekToken() == 'n')
+            {
+                out.reset();
+                return reader.readLiteral("null");
+            }
+            return readValue(reader, out.emplace(), depth);
+        }
+        else if constexpr (IsStdVector<T>::value)
+        {
+            out.clear();
+            bool hasElements{false};
+            reader.enterArray(hasElements);
+            while (hasElements)
+            {
+                if (!readValue(reader, out.emplace_back(), depth + 1) || !reader.nextElement(hasElements))
+                {
+                    return false;
+                }
+            }
+            return reader.ok();
+        }
+        else if constexpr (std::is_same_v<T, Json::JsonFieldValue>)
+        {
+            return readFieldValue(reader, out, depth);
+        }
+        else if constexpr (IsJsonBound<T>::value)
+        {
+            return readObject(reader, out, depth);
+        }
+        else
+        {
+            static_assert(IsJsonBound<T>::value, "Type has no JSON binding, use HK_JSON_BIND on it");
+        }
+    }
+
+    template <typename T> static void writeValue(const T& value, JsonWriter& writer)
+    {
+        if constexpr (std::is_same_v<T, bool>)
+        {
+            writer.value(value);
+        }
+        else if constexpr (std::is_integral_v<T>)
+        {
+            writer.value((int64_t)value);
+        }
+        else if constexpr (std::is_floating_point_v<T>)
+        {
+            writer.value((double)value);
+        }
+        else if constexpr (std::is_same_v<T, std::string>)
+        {
+            writer.value(std::string_view{value});
+        }
+        else if constexpr (IsStdOptional<T>::value)
+        {
+            if (value.has_value())
+            {
+                writeValue(*value, writer);
+            }
+            else
+            {
+                writer.value(Json::JsonNull{});
+            }
+        }
+        else if constexpr (IsStdVector<T>::value)
+        {
+            writer.beginArray();
+            for (const auto& item : value)
+            {
+                writeValue(item, writer);
+            }
+            writer.endArray();
+        }
+        else if constexpr (std::is_same_v<T, Json::JsonFieldValue>)
+        {
+            writer.value(value);
+        }
+        else if constexpr (IsJsonBound<T>::value)
+        {
+            writer.beginObject();
+            std::apply([&value, &writer](const auto&... field)
+            {
+                ((writer.key(field.key), writeValue(value.*(field.member), writer)), ...);
+            }, JsonBinding<T>::fields);
+            writer.endObject();
+        }
+        else
+        {
+            static_assert(IsJsonBound<T>::value, "Type has no JSON binding, use HK_JSON_BIND on it");
+        }
+    }
+
+private:
+    template <typename T> static bool readObject(JsonReader& reader, T& out, const uint32_t depth)
+    {
+        bool hasMembers{false};
+        reader.enterObject(hasMembers);
+
+        std::string decodedKey;
+        int32_t predicted{0};
+        while (hasMembers)
+        {
+            std::string_view key;
+            bool hasEscapes{false};
+            if (!reader.readKey(key, hasEscapes))
+            {
+                return false;
+            }
+
+            /* Escaped keys are rare, decode them on the side only when they show up. */
+            if (hasEscapes)
+            {
+                decodedKey.clear();
+                JsonReader::decodeEscapes(key, decodedKey);
+                key = decodedKey;
+            }
+
+            /* Documents of one shape keep their key order, so the key after the last matched one is tried with
+               a plain memcmp first. Anything else (reordered, unknown, escaped keys) goes through the hash. */
+            int32_t index{-1};
+            const bool hasPrediction = (uint64_t)predicted < JsonKeyIndex<T>::FIELD_COUNT;
+            const std::string_view expected = hasPrediction ? JsonKeyIndex<T>::KEYS[predicted] : std::string_view{};
+            if (hasPrediction && key.size() == expected.size() &&
+                std::memcmp(key.data(), expected.data(), key.size()) == 0)
+            {
+                index = predicted;
+            }
+            else
+            {
+                index = JsonKeyIndex<T>::find(key);
+            }
+            predicted = index + 1;
+
+            const bool valueRead = index < 0 ? reader.skipValue(depth + 1) : readField(reader, out, index, depth + 1);
+            if (!valueRead || !reader.nextMember(hasMembers))
+            {
+                return false;
+            }
+        }
+        return reader.ok();
+    }
+
+    template <typename T, uint64_t I> static bool readFieldAt(JsonReader& reader, T& out, const uint32_t depth)
+    {
+        return readValue(reader, out.*(std::get<I>(JsonBinding<T>::fields).member), depth);
+    }
+
+    /**
+        @brief Jump table with one reader per field, each one inlines the member's type specific parse.
+    */
+    template <typename T> static bool readField(JsonReader& reader, T& out, const int32_t index, const uint32_t depth)
+    {
+        using FieldReader = bool (*)(JsonReader&, T&, const uint32_t);
+        static constexpr auto READERS = []<uint64_t... I>(std::index_sequence<I...>)
+        {
+            return std::array<FieldReader, sizeof...(I)>{&readFieldAt<T, I>...};
+        }(std::make_index_sequence<JsonKeyIndex<T>::FIELD_COUNT>{});
+
+        return READERS[index](reader, out, depth);
+    }
+
+    static bool readFieldValue(JsonReader& reader, Json::JsonFieldValue& out, const uint32_t depth)
+    {
+        if (depth > JsonReader::MAX_DEPTH)
+        {
+            return reader.fail("Document nested too deep");
+        }
+
+        switch (reader.peekToken())
+        {
+            case '{': {
+                Json::JsonObjectNode objNode;
+                bool hasMembers{false};
+                reader.enterObject(hasMembers);
+                while (hasMembers)
+                {
+                    std::string_view rawKey;
+                    bool hasEscapes{false};
+                    if (!reader.readKey(rawKey, hasEscapes))
+                    {
+                        return false;
+                    }
+
+                    std::string key;
+                    if (hasEscapes)
+                    {
+                        JsonReader::decodeEscapes(rawKey, key);
+                    }
+                    else
+                    {
+                        key.assign(rawKey);
+                    }
+                    if (!readFieldValue(reader, objNode[std::move(key)], depth + 1) || !reader.nextMember(hasMembers))
+                    {
+                        return false;
+                    }
+                }
+                out = std::move(objNode);
+                return reader.ok();
+            }
+            case '[': {
+                Json::JsonListNode listNode;
+                bool hasElements{false};
+                reader.enterArray(hasElements);
+                while (hasElements)
+                {
+                    if (!readFieldValue(reader, listNode.emplace_back(), depth + 1) || !reader.nextElement(hasElements))
+                    {
+                        return false;
+                    }
+                }
+                out = std::move(listNode);
+                return reader.ok();
+            }
+            case '"': {
+                std::string str;
+                if (!reader.readString(str))
+                {
+                    return false;
+                }
+                out = std::move(str);
+                return true;
+            }
+            case 't':
+                out = true;
+                return reader.readLiteral("true");
+            case 'f':
+                out = false;
+                return reader.readLiteral("false");
+            case 'n':
+                out = Json::JsonNull{};
+                return reader.readLiteral("null");
+            default: {
+                std::string_view raw;
+                bool isInteger{false};
+                int64_t number{0};
+                if (!reader.readNumber(raw, isInteger))
+                {
+                    return false;
+                }
+
+                /* Integers too big for int64 degrade to double rather than failing. */
+                if (isInteger && JsonReader::toInt64(raw, number))
+                {
+                    out = number;
+                }
+                else
+                {
+                    out = JsonReader::toDouble(raw);
+                }
+                return true;
+            }
+        }
+    }
+};
+
+} // namespace hk
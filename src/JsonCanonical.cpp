@@ -0,0 +1,217 @@
+#include "JsonCanonical.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstring>
+
+namespace hk
+{
+
+namespace
+{
+/* Integers with a magnitude up to 2^53 are exact doubles and print the same either way. */
+constexpr int64_t MAX_EXACT_INT{1LL << 53};
+} // namespace
+
+JsonCanonicalSerializer::JsonCanonicalSerializer(OutputBuffer& outBuffer)
+    : out{outBuffer}
+    , serializer{outBuffer}
+{}
+
+void JsonCanonicalSerializer::write(const Json::JsonRootNode& node)
+{
+    if (std::holds_alternative<Json::JsonObjectNode>(node))
+    {
+        writeObject(std::get<Json::JsonObjectNode>(node));
+    }
+    else if (std::holds_alternative<Json::JsonListNode>(node))
+    {
+        writeList(std::get<Json::JsonListNode>(node));
+    }
+}
+
+void JsonCanonicalSerializer::writeObject(const Json::JsonObjectNode& objNode)
+{
+    /* Nested objects push theirs past ours, so entries are reached by index. */
+    const uint64_t begin = entries.size();
+    for (const Entry& entry : objNode)
+    {
+        entries.push_back(&entry);
+    }
+    std::sort(entries.begin() + begin, entries.end(),
+        [](const Entry* lhs, const Entry* rhs) { return keyLess(lhs->first, rhs->first); });
+
+    out.append('{');
+    for (uint64_t i{begin}; i < begin + objNode.size(); i++)
+    {
+        if (i != begin)
+        {
+            out.append(',');
+        }
+
+        serializer.writeString(entries[i]->first);
+        out.append(':');
+        writeValue(entries[i]->second);
+    }
+    out.append('}');
+    entries.resize(begin);
+}
+
+void JsonCanonicalSerializer::writeList(const Json::JsonListNode& listNode)
+{
+    out.append('[');
+    bool first{true};
+    for (const auto& v : listNode)
+    {
+        if (!first)
+        {
+            out.append(',');
+        }
+        first = false;
+
+        writeValue(v);
+    }
+    out.append(']');
+}
+
+void JsonCanonicalSerializer::writeValue(const Json::JsonFieldValue& value)
+{
+    if (value.isNull())
+    {
+        serializer.writeNull();
+    }
+    else if (value.isBool())
+    {
+        serializer.writeBool(value.getBool());
+    }
+    else if (value.isString())
+    {
+        serializer.writeString(value.getString());
+    }
+    else if (value.isInt())
+    {
+        const int64_t number = value.getInt();
+        if (number >= -MAX_EXACT_INT && number <= MAX_EXACT_INT)
+        {
+            serializer.writeInt(number);
+        }
+        else
+        {
+            writeNumber((double)number);
+        }
+    }
+    else if (value.isDouble())
+    {
+        writeNumber(value.getDouble());
+    }
+    else if (value.isObject())
+    {
+        writeObject(value.getObject());
+    }
+    else if (value.isList())
+    {
+        writeList(value.getList());
+    }
+}
+
+void JsonCanonicalSerializer::writeNumber(const double number)
+{
+    /* Not representable in JSON at all, same fallback as the regular serializer. */
+    if (!std::isfinite(number))
+    {
+        serializer.writeNull();
+        return;
+    }
+    if (number == 0)
+    {
+        out.append('0');
+        return;
+    }
+
+    /* Shortest round trip digits in the form d.ddde[+-]x, from which the ECMAScript layout is built. */
+    char scientific[32];
+    const std::to_chars_result res =
+        std::to_chars(scientific, scientific + sizeof(scientific), std::fabs(number), std::chars_format::scientific);
+    const char* exponentMark = (const char*)memchr(scientific, 'e', res.ptr - scientific);
+
+    char digits[20];
+    int32_t digitCount{0};
+    for (const char* cursor = scientific; cursor < exponentMark; cursor++)
+    {
+        if (*cursor != '.')
+        {
+            digits[digitCount++] = *cursor;
+        }
+    }
+
+    const char* exponentStart = exponentMark + 1 + (exponentMark[1] == '+');
+    int32_t exponent{0};
+    std::from_chars(exponentStart, res.ptr, exponent);
+
+    /* Value is 0.digits * 10^point */
+    const int32_t point = exponent + 1;
+    char text[48];
+    char* cursor = text;
+    if (number < 0)
+    {
+        *cursor++ = '-';
+    }
+
+    if (digitCount <= point && point <= 21)
+    {
+        cursor = std::copy_n(digits, digitCount, cursor);
+        cursor = std::fill_n(cursor, point - digitCount, '0');
+    }
+    else if (0 < point && point <= 21)
+    {
+        cursor = std::copy_n(digits, point, cursor);
+        *cursor++ = '.';
+        cursor = std::copy_n(digits + point, digitCount - point, cursor);
+    }
+    else if (-6 < point && point <= 0)
+    {
+        *cursor++ = '0';
+        *cursor++ = '.';
+        cursor = std::fill_n(cursor, -point, '0');
+        cursor = std::copy_n(digits, digitCount, cursor);
+    }
+    else
+    {
+        *cursor++ = digits[0];
+        if (digitCount > 1)
+        {
+            *cursor++ = '.';
+            cursor = std::copy_n(digits + 1, digitCount - 1, cursor);
+        }
+        *cursor++ = 'e';
+        *cursor++ = point - 1 < 0 ? '-' : '+';
+        cursor = std::to_chars(cursor, text + sizeof(text), std::abs(point - 1)).ptr;
+    }
+    out.append(text, cursor - text);
+}
+
+bool JsonCanonicalSerializer::keyLess(const std::string_view lhs, const std::string_view rhs)
+{
+    const auto [lhsIt, rhsIt] = std::mismatch(lhs.begin(), lhs.end(), rhs.begin(), rhs.end());
+    if (lhsIt == lhs.end() || rhsIt == rhs.end())
+    {
+        return lhs.size() < rhs.size();
+    }
+
+    /* The bytes before are equal, so both differing bytes are lead bytes or both are continuation bytes.
+       4 byte sequences become surrogates (0xd800..) in UTF-16 and sort before U+E000..U+FFFF (lead 0xee/0xef). */
+    const uint8_t lhsByte = *lhsIt;
+    const uint8_t rhsByte = *rhsIt;
+    if (lhsByte >= 0xf0 && (rhsByte == 0xee || rhsByte == 0xef))
+    {
+        return true;
+    }
+    if (rhsByte >= 0xf0 && (lhsByte == 0xee || lhsByte == 0xef))
+    {
+        return false;
+    }
+    return lhsByte < rhsByte;
+}
+
+} // namespace hk
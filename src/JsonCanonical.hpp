@@ -0,0 +1,48 @@
+#pragma once
+
+#include "HkJson.hpp"
+#include "JsonSerializer.hpp"
+#include "OutputBuffer.hpp"
+
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace hk
+{
+
+/* RFC 8785 (JCS) canonical writer: equal documents always produce the same bytes, ready to be hashed.
+    - No whitespace. Strings are escaped like the regular serializer does, which is already what JCS asks for.
+    - Object members are sorted by their keys' UTF-16 code units. Only pointers to the entries get sorted, in one
+      scratch buffer reused by every object of the document, so no map is copied.
+    - Numbers are written the way ECMAScript prints doubles: shortest round trip digits, exponent form only below
+      1e-6 or from 1e21 up, "-0" printed as "0". Integers past 2^53 go through double as JCS requires.
+*/
+class JsonCanonicalSerializer
+{
+public:
+    explicit JsonCanonicalSerializer(OutputBuffer& out);
+
+    void write(const Json::JsonRootNode& node);
+    void writeObject(const Json::JsonObjectNode& objNode);
+    void writeList(const Json::JsonListNode& listNode);
+    void writeValue(const Json::JsonFieldValue& value);
+    void writeNumber(const double number);
+
+    /**
+        @brief Key order of JCS: UTF-16 code unit order, which only differs from UTF-8 byte order when
+            U+E000..U+FFFF meets characters past U+FFFF.
+    */
+    static bool keyLess(const std::string_view lhs, const std::string_view rhs);
+
+private:
+    using Entry = std::pair<const std::string, Json::JsonFieldValue>;
+
+    OutputBuffer& out;
+    JsonSerializer serializer;
+
+    /* Entries of every object being written, innermost last. */
+    std::vector<const Entry*> entries;
+};
+
+} // namespace hk
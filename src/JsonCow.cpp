@@ -0,0 +1,346 @@
+#include "JsonCow.hpp"
+
+namespace hk
+{
+
+namespace
+{
+const JsonCowValue NULL_VALUE{};
+const std::string EMPTY_STRING{};
+const JsonCowValue::Object EMPTY_OBJECT{};
+const JsonCowValue::List EMPTY_LIST{};
+} // namespace
+
+JsonCowValue::JsonCowValue(const Json::JsonNull)
+    : value{Json::JsonNull{}}
+{}
+
+JsonCowValue::JsonCowValue(const bool val)
+    : value{val}
+{}
+
+JsonCowValue::JsonCowValue(const int32_t val)
+    : value{(int64_t)val}
+{}
+
+JsonCowValue::JsonCowValue(const int64_t val)
+    : value{val}
+{}
+
+JsonCowValue::JsonCowValue(const double val)
+    : value{val}
+{}
+
+JsonCowValue::JsonCowValue(const char* val)
+    : value{std::string{val}}
+{}
+
+JsonCowValue::JsonCowValue(std::string val)
+    : value{std::move(val)}
+{}
+
+JsonCowValue::JsonCowValue(Object val)
+    : value{std::make_shared<Object>(std::move(val))}
+{}
+
+JsonCowValue::JsonCowValue(List val)
+    : value{std::make_shared<List>(std::move(val))}
+{}
+
+JsonCowValue JsonCowValue::fromRoot(const Json::JsonRootNode& root)
+{
+    if (std::holds_alternative<Json::JsonListNode>(root))
+    {
+        List list;
+        list.reserve(std::get<Json::JsonListNode>(root).size());
+        for (const Json::JsonFieldValue& element : std::get<Json::JsonListNode>(root))
+        {
+            list.emplace_back(fromFieldValue(element));
+        }
+        return list;
+    }
+
+    Object object;
+    object.reserve(std::get<Json::JsonObjectNode>(root).size());
+    for (const auto& [key, entry] : std::get<Json::JsonObjectNode>(root))
+    {
+        object.emplace(key, fromFieldValue(entry));
+    }
+    return object;
+}
+
+JsonCowValue JsonCowValue::fromFieldValue(const Json::JsonFieldValue& val)
+{
+    if (val.isBool())
+    {
+        return val.getBool();
+    }
+    else if (val.isInt())
+    {
+        return val.getInt();
+    }
+    else if (val.isDouble())
+    {
+        return val.getDouble();
+    }
+    else if (val.isString())
+    {
+        return val.getString();
+    }
+    else if (val.isObject())
+    {
+        Object object;
+        object.reserve(val.getObject().size());
+        for (const auto& [key, entry] : val.getObject())
+        {
+            object.emplace(key, fromFieldValue(entry));
+        }
+        return object;
+    }
+    else if (val.isList())
+    {
+        List list;
+        list.reserve(val.getList().size());
+        for (const Json::JsonFieldValue& element : val.getList())
+        {
+            list.emplace_back(fromFieldValue(element));
+        }
+        return list;
+    }
+    return {};
+}
+
+Json::JsonFieldValue JsonCowValue::toFieldValue() const
+{
+    /* Containers are move assigned, the implicit constructors would copy them once more. */
+    Json::JsonFieldValue result;
+    if (isBool())
+    {
+        result.internalVariant = getBool();
+    }
+    else if (isInt())
+    {
+        result.internalVariant = getInt();
+    }
+    else if (isDouble())
+    {
+        result.internalVariant = getDouble();
+    }
+    else if (isString())
+    {
+        result = getString();
+    }
+    else if (isObject())
+    {
+        Json::JsonObjectNode objNode;
+        objNode.reserve(size());
+        for (const auto& [key, entry] : getObject())
+        {
+            objNode.emplace(key, entry.toFieldValue());
+        }
+        result = std::move(objNode);
+    }
+    else if (isList())
+    {
+        Json::JsonListNode listNode;
+        listNode.reserve(size());
+        for (const JsonCowValue& element : getList())
+        {
+            listNode.emplace_back(element.toFieldValue());
+        }
+        result = std::move(listNode);
+    }
+    else
+    {
+        result = Json::JsonNull{};
+    }
+    return result;
+}
+
+Json::JsonRootNode JsonCowValue::toRootNode() const
+{
+    Json::JsonFieldValue rootValue = toFieldValue();
+    if (rootValue.isList())
+    {
+        return Json::JsonRootNode{std::move(rootValue.getList())};
+    }
+    else if (rootValue.isObject())
+    {
+        return Json::JsonRootNode{std::move(rootValue.getObject())};
+    }
+    return Json::JsonRootNode{Json::JsonObjectNode{}};
+}
+
+bool JsonCowValue::isNull() const
+{
+    return std::holds_alternative<Json::JsonNull>(value);
+}
+
+bool JsonCowValue::isBool() const
+{
+    return std::holds_alternative<bool>(value);
+}
+
+bool JsonCowValue::isInt() const
+{
+    return std::holds_alternative<int64_t>(value);
+}
+
+bool JsonCowValue::isDouble() const
+{
+    return std::holds_alternative<double>(value);
+}
+
+bool JsonCowValue::isString() const
+{
+    return std::holds_alternative<std::string>(value);
+}
+
+bool JsonCowValue::isObject() const
+{
+    return std::holds_alternative<ObjectPtr>(value);
+}
+
+bool JsonCowValue::isList() const
+{
+    return std::holds_alternative<ListPtr>(value);
+}
+
+bool JsonCowValue::getBool() const
+{
+    return isBool() && std::get<bool>(value);
+}
+
+int64_t JsonCowValue::getInt() const
+{
+    return isInt() ? std::get<int64_t>(value) : 0;
+}
+
+double JsonCowValue::getDouble() const
+{
+    return isDouble() ? std::get<double>(value) : 0;
+}
+
+const std::string& JsonCowValue::getString() const
+{
+    return isString() ? std::get<std::string>(value) : EMPTY_STRING;
+}
+
+const JsonCowValue::Object& JsonCowValue::getObject() const
+{
+    return isObject() ? *std::get<ObjectPtr>(value) : EMPTY_OBJECT;
+}
+
+const JsonCowValue::List& JsonCowValue::getList() const
+{
+    return isList() ? *std::get<ListPtr>(value) : EMPTY_LIST;
+}
+
+uint64_t JsonCowValue::size() const
+{
+    if (isObject())
+    {
+        return getObject().size();
+    }
+    return isList() ? getList().size() : 0;
+}
+
+const JsonCowValue& JsonCowValue::operator[](const std::string& key) const
+{
+    const JsonCowValue* entry = find(key);
+    return entry != nullptr ? *entry : NULL_VALUE;
+}
+
+const JsonCowValue& JsonCowValue::operator[](const uint64_t index) const
+{
+    const List& list = getList();
+    return index < list.size() ? list[index] : NULL_VALUE;
+}
+
+const JsonCowValue* JsonCowValue::find(const std::string& key) const
+{
+    const Object& object = getObject();
+    const auto it = object.find(key);
+    return it != object.end() ? &it->second : nullptr;
+}
+
+JsonCowValue::Object& JsonCowValue::editObject()
+{
+    ObjectPtr& object = std::get<ObjectPtr>(value);
+
+    /* Only this value holds it: nobody else can start sharing it meanwhile, editing in place is safe. */
+    if (object.use_count() > 1)
+    {
+        object = std::make_shared<Object>(*object);
+    }
+    return *object;
+}
+
+JsonCowValue::List& JsonCowValue::editList()
+{
+    ListPtr& list = std::get<ListPtr>(value);
+    if (list.use_count() > 1)
+    {
+        list = std::make_shared<List>(*list);
+    }
+    return *list;
+}
+
+const JsonCowValue& JsonCowValue::at(const std::string& key) const
+{
+    return std::get<ObjectPtr>(value)->at(key);
+}
+
+const JsonCowValue& JsonCowValue::at(const uint64_t index) const
+{
+    return std::get<ListPtr>(value)->at(index);
+}
+
+JsonCowValue& JsonCowValue::editEntry(const std::string& key)
+{
+    return editObject()[key];
+}
+
+JsonCowValue& JsonCowValue::editElement(const uint64_t index)
+{
+    if (index >= std::get<ListPtr>(value)->size())
+    {
+        throw std::out_of_range{"JsonCowValue::editElement index out of range"};
+    }
+    return editList()[index];
+}
+
+void JsonCowValue::set(const std::string& key, JsonCowValue val)
+{
+    editObject().insert_or_assign(key, std::move(val));
+}
+
+bool JsonCowValue::erase(const std::string& key)
+{
+    /* Don't clone just to find out there's nothing to erase. */
+    if (find(key) == nullptr)
+    {
+        return false;
+    }
+    return editObject().erase(key) != 0;
+}
+
+void JsonCowValue::push(JsonCowValue val)
+{
+    editList().emplace_back(std::move(val));
+}
+
+bool JsonCowValue::sharesWith(const JsonCowValue& other) const
+{
+    if (isObject() && other.isObject())
+    {
+        return std::get<ObjectPtr>(value) == std::get<ObjectPtr>(other.value);
+    }
+    else if (isList() && other.isList())
+    {
+        return std::get<ListPtr>(value) == std::get<ListPtr>(other.value);
+    }
+    return false;
+}
+
+} // namespace hk
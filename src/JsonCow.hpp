@@ -0,0 +1,129 @@
+#pragma once
+
+#include "HkJson.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <variant>
+#include <vector>
+
+namespace hk
+{
+
+/* Copy-on-write document value: copies share their subtrees, which get cloned only when mutated.
+    - Objects and lists are held through reference counted pointers, so copying a value of any size only bumps
+      one counter.
+    - Editing accessors (editEntry, editElement, set, erase, push, editObject, editList) first clone the
+      container they touch if anybody else still holds it. Editing a nested value clones just the containers along its path, every
+      sibling subtree stays shared with the other copies.
+    - Read only accessors (operator[], at, find, get*) never copy. References returned by the editing accessors are only good until the value
+      (or one of its parents) gets copied again.
+
+    JsonCowValue base = JsonCowValue::fromRoot(*json.loadFromFile("base.json").json);
+    JsonCowValue tenant = base;
+    tenant.editEntry("limits").set("cpu", int64_t{4});
+*/
+class JsonCowValue
+{
+public:
+    using Object = std::unordered_map<std::string, JsonCowValue>;
+    using List = std::vector<JsonCowValue>;
+
+    JsonCowValue() = default;
+    JsonCowValue(const Json::JsonNull);
+    JsonCowValue(const bool val);
+    JsonCowValue(const int32_t val);
+    JsonCowValue(const int64_t val);
+    JsonCowValue(const double val);
+    JsonCowValue(const char* val);
+    JsonCowValue(std::string val);
+    JsonCowValue(Object val);
+    JsonCowValue(List val);
+
+    /**
+        @brief One time conversion of a regular document (or value). The result can then be copied for free.
+    */
+    static JsonCowValue fromRoot(const Json::JsonRootNode& root);
+    static JsonCowValue fromFieldValue(const Json::JsonFieldValue& value);
+
+    /**
+        @brief Materialize this value (and everything below it) back into a regular DOM value.
+    */
+    Json::JsonFieldValue toFieldValue() const;
+
+    /**
+        @brief Same as toFieldValue for an object/list value, as a regular document. Scalars give an empty object.
+    */
+    Json::JsonRootNode toRootNode() const;
+
+    bool isNull() const;
+    bool isBool() const;
+    bool isInt() const;
+    bool isDouble() const;
+    bool isString() const;
+    bool isObject() const;
+    bool isList() const;
+
+    bool getBool() const;
+    int64_t getInt() const;
+    double getDouble() const;
+    const std::string& getString() const;
+    const Object& getObject() const;
+    const List& getList() const;
+
+    /**
+        @brief Number of entries for objects and lists, 0 otherwise.
+    */
+    uint64_t size() const;
+
+    /**
+        @brief Read only lookups, nothing is cloned. Missing keys and out of range indices give a null value.
+    */
+    const JsonCowValue& operator[](const std::string& key) const;
+    const JsonCowValue& operator[](const uint64_t index) const;
+    const JsonCowValue* find(const std::string& key) const;
+
+    /**
+        @brief Read only lookups like std::map::at: missing keys and out of range indices throw std::out_of_range,
+            the wrong type throws std::bad_variant_access. Nothing is cloned.
+    */
+    const JsonCowValue& at(const std::string& key) const;
+    const JsonCowValue& at(const uint64_t index) const;
+
+    /**
+        @brief Mutable access to the object/list owned by this value only, cloning it first if it's shared.
+            Like the DOM accessors, asking for the wrong type throws std::bad_variant_access.
+    */
+    Object& editObject();
+    List& editList();
+
+    /**
+        @brief Mutable entry, inserted as null if the key is missing. Clones the object if it's shared.
+    */
+    JsonCowValue& editEntry(const std::string& key);
+
+    /**
+        @brief Mutable element, std::out_of_range if _index_ is past the end (checked before cloning). Clones the
+            list if it's shared.
+    */
+    JsonCowValue& editElement(const uint64_t index);
+
+    void set(const std::string& key, JsonCowValue val);
+    bool erase(const std::string& key);
+    void push(JsonCowValue val);
+
+    /**
+        @brief True if both values point to the very same object/list, i.e. no copy happened between them yet.
+    */
+    bool sharesWith(const JsonCowValue& other) const;
+
+private:
+    using ObjectPtr = std::shared_ptr<Object>;
+    using ListPtr = std::shared_ptr<List>;
+
+    std::variant<Json::JsonNull, bool, int64_t, double, std::string, ObjectPtr, ListPtr> value;
+};
+
+} // namespace hk
@@ -0,0 +1,277 @@
+#include "JsonDiff.hpp"
+
+#include "JsonPatch.hpp"
+#include <algorithm>
+
+namespace hk
+{
+
+Json::JsonListNode JsonDiff::diff(const Json::JsonRootNode& from, const Json::JsonRootNode& to)
+{
+    JsonDiff differ;
+    std::string path;
+    const bool fromIsObject = std::holds_alternative<Json::JsonObjectNode>(from);
+    const bool toIsObject = std::holds_alternative<Json::JsonObjectNode>(to);
+    if (fromIsObject && toIsObject)
+    {
+        differ.diffObjects(std::get<Json::JsonObjectNode>(from), std::get<Json::JsonObjectNode>(to), path);
+    }
+    else if (!fromIsObject && !toIsObject)
+    {
+        differ.diffLists(std::get<Json::JsonListNode>(from), std::get<Json::JsonListNode>(to), path);
+    }
+    else
+    {
+        Json::JsonFieldValue whole;
+        if (toIsObject)
+        {
+            whole = std::get<Json::JsonObjectNode>(to);
+        }
+        else
+        {
+            whole = std::get<Json::JsonListNode>(to);
+        }
+        differ.emit("replace", path, &whole);
+    }
+    return std::move(differ.patch);
+}
+
+void JsonDiff::diffValue(const Json::JsonFieldValue& from, const Json::JsonFieldValue& to, std::string& path)
+{
+    if (hashes.equal(from, to))
+    {
+        return;
+    }
+
+    if (from.isObject() && to.isObject())
+    {
+        diffObjects(from.getObject(), to.getObject(), path);
+    }
+    else if (from.isList() && to.isList())
+    {
+        diffLists(from.getList(), to.getList(), path);
+    }
+    else
+    {
+        emit("replace", path, &to);
+    }
+}
+
+void JsonDiff::diffObjects(const Json::JsonObjectNode& from, const Json::JsonObjectNode& to, std::string& path)
+{
+    if (hashes.hash(from) == hashes.hash(to))
+    {
+        return;
+    }
+
+    const uint64_t pathSize = path.size();
+    for (const auto& [key, fromValue] : from)
+    {
+        JsonPatch::appendPointerToken(path, key);
+        const auto it = to.find(key);
+        if (it == to.end())
+        {
+            emit("remove", path, nullptr);
+        }
+        else
+        {
+            diffValue(fromValue, it->second, path);
+        }
+        path.resize(pathSize);
+    }
+
+    for (const auto& [key, toValue] : to)
+    {
+        if (!from.contains(key))
+        {
+            JsonPatch::appendPointerToken(path, key);
+            emit("add", path, &toValue);
+            path.resize(pathSize);
+        }
+    }
+}
+
+void JsonDiff::diffLists(const Json::JsonListNode& from, const Json::JsonListNode& to, std::string& path)
+{
+    if (hashes.hash(from) == hashes.hash(to))
+    {
+        return;
+    }
+
+    /* Common head and tail never make it into the alignment. */
+    const uint64_t shorter = std::min(from.size(), to.size());
+    uint64_t head{0};
+    while (head < shorter && hashes.equal(from[head], to[head]))
+    {
+        head++;
+    }
+    uint64_t tail{0};
+    while (tail < shorter - head && hashes.equal(from[from.size() - 1 - tail], to[to.size() - 1 - tail]))
+    {
+        tail++;
+    }
+
+    std::vector<uint64_t> fromHashes;
+    std::vector<uint64_t> toHashes;
+    fromHashes.reserve(from.size() - head - tail);
+    toHashes.reserve(to.size() - head - tail);
+    for (uint64_t i{head}; i < from.size() - tail; i++)
+    {
+        fromHashes.push_back(hashes.hash(from[i]));
+    }
+    for (uint64_t i{head}; i < to.size() - tail; i++)
+    {
+        toHashes.push_back(hashes.hash(to[i]));
+    }
+    const std::vector<Edit> script = alignLists(fromHashes, toHashes);
+
+    /* Indices in the patch refer to the array as it is while being patched: _position_ follows that. */
+    const uint64_t pathSize = path.size();
+    uint64_t position{head};
+    uint64_t fromIndex{head};
+    uint64_t toIndex{head};
+    uint64_t edit{0};
+    while (edit < script.size())
+    {
+        if (script[edit] == Edit::KEEP)
+        {
+            /* Aligned on equal hashes, a scalar still gets its exact check. */
+            if (!hashes.equal(from[fromIndex], to[toIndex]))
+            {
+                JsonPatch::appendPointerToken(path, std::to_string(position));
+                emit("replace", path, &to[toIndex]);
+                path.resize(pathSize);
+            }
+            position++;
+            fromIndex++;
+            toIndex++;
+            edit++;
+            continue;
+        }
+
+        uint64_t removed{0};
+        uint64_t inserted{0};
+        for (; edit < script.size() && script[edit] != Edit::KEEP; edit++)
+        {
+            (script[edit] == Edit::REMOVE ? removed : inserted)++;
+        }
+
+        /* Removals facing insertions are the same slot changing, diff them instead of replacing them. */
+        const uint64_t paired = std::min(removed, inserted);
+        for (uint64_t i{0}; i < removed; i++)
+        {
+            JsonPatch::appendPointerToken(path, std::to_string(position));
+            if (i < paired)
+            {
+                diffValue(from[fromIndex + i], to[toIndex + i], path);
+                position++;
+            }
+            else
+            {
+                emit("remove", path, nullptr);
+            }
+            path.resize(pathSize);
+        }
+        for (uint64_t i{paired}; i < inserted; i++)
+        {
+            JsonPatch::appendPointerToken(path, std::to_string(position));
+            emit("add", path, &to[toIndex + i]);
+            path.resize(pathSize);
+            position++;
+        }
+        fromIndex += removed;
+        toIndex += inserted;
+    }
+}
+
+std::vector<JsonDiff::Edit> JsonDiff::alignLists(const std::vector<uint64_t>& from,
+    const std::vector<uint64_t>& to) const
+{
+    /* Myers' greedy algorithm: frontier[k] is the furthest _from_ index reached on diagonal k = x - y with the
+       current number of edits. The frontier of every round is kept to walk the path back afterwards. */
+    const int64_t fromSize = from.size();
+    const int64_t toSize = to.size();
+    const int64_t maxEdits = std::min<int64_t>(fromSize + toSize, MAX_EDIT_DISTANCE);
+    std::vector<std::vector<int32_t>> rounds;
+    std::vector<int32_t> frontier(2 * maxEdits + 3, 0);
+    const int64_t center = maxEdits + 1;
+
+    int64_t edits{-1};
+    for (int64_t d{0}; d <= maxEdits && edits < 0; d++)
+    {
+        for (int64_t k = -d; k <= d; k += 2)
+        {
+            const bool down = k == -d || (k != d && frontier[center + k - 1] < frontier[center + k + 1]);
+            int64_t x = down ? frontier[center + k + 1] : frontier[center + k - 1] + 1;
+            int64_t y = x - k;
+            while (x < fromSize && y < toSize && from[x] == to[y])
+            {
+                x++;
+                y++;
+            }
+            frontier[center + k] = (int32_t)x;
+
+            if (x >= fromSize && y >= toSize)
+            {
+                edits = d;
+                break;
+            }
+        }
+        rounds.emplace_back(frontier.begin() + center - d, frontier.begin() + center + d + 1);
+    }
+
+    std::vector<Edit> script;
+    script.reserve(from.size() + to.size());
+    if (edits < 0)
+    {
+        /* Too different to align, pair elements up by position. */
+        const uint64_t shorter = std::min(from.size(), to.size());
+        script.insert(script.end(), shorter, Edit::REMOVE);
+        script.insert(script.end(), shorter, Edit::INSERT);
+        script.insert(script.end(), from.size() - shorter, Edit::REMOVE);
+        script.insert(script.end(), to.size() - shorter, Edit::INSERT);
+        return script;
+    }
+
+    /* Walk back from the end, the script comes out reversed. */
+    int64_t x = fromSize;
+    int64_t y = toSize;
+    for (int64_t d = edits; d > 0; d--)
+    {
+        const std::vector<int32_t>& previous = rounds[d - 1];
+        const auto reached = [&previous, d](const int64_t k) { return (int64_t)previous[k + d - 1]; };
+
+        const int64_t k = x - y;
+        const bool down = k == -d || (k != d && reached(k - 1) < reached(k + 1));
+        const int64_t previousK = down ? k + 1 : k - 1;
+        const int64_t previousX = reached(previousK);
+        const int64_t previousY = previousX - previousK;
+        for (; x > (down ? previousX : previousX + 1); x--, y--)
+        {
+            script.push_back(Edit::KEEP);
+        }
+        script.push_back(down ? Edit::INSERT : Edit::REMOVE);
+        x = previousX;
+        y = previousY;
+    }
+    script.insert(script.end(), x, Edit::KEEP);
+    std::reverse(script.begin(), script.end());
+    return script;
+}
+
+void JsonDiff::emit(const char* op, const std::string& path, const Json::JsonFieldValue* value)
+{
+    Json::JsonObjectNode operation;
+    operation.emplace("op", std::string{op});
+    operation.emplace("path", path);
+    if (value != nullptr)
+    {
+        operation.emplace("value", *value);
+    }
+
+    Json::JsonFieldValue entry;
+    entry = std::move(operation);
+    patch.emplace_back(std::move(entry));
+}
+
+} // namespace hk
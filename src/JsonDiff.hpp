@@ -0,0 +1,52 @@
+#pragma once
+
+#include "HkJson.hpp"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace hk
+{
+
+/* Structural diff producing an RFC 6902 patch (see JsonPatch) that turns one document into another.
+    - Subtrees are compared through their Merkle hashes (Json::hashValue), memoized in a Json::HashCache for the
+      length of one diff() call. Subtrees with equal hashes are skipped without being walked.
+    - Objects are matched by key. Arrays drop their common head and tail first, then the rest is aligned with a
+      shortest edit script (Myers) over element hashes, costing O((N + M) * edits). Elements left facing each
+      other are diffed recursively instead of being replaced whole. Past MAX_EDIT_DISTANCE insertions plus
+      removals the alignment gives up and pairs elements by position.
+    - 64 bit hashes are trusted for containers: equal hashes count as equal subtrees. Scalars are confirmed with
+      Json::valuesEqual, so numbers that differ past double precision still show up.
+*/
+class JsonDiff
+{
+public:
+    static constexpr int64_t MAX_EDIT_DISTANCE{2048};
+
+    /**
+        @brief Patch turning _from_ into _to_, empty if they are equal.
+    */
+    static Json::JsonListNode diff(const Json::JsonRootNode& from, const Json::JsonRootNode& to);
+
+private:
+    enum class Edit : uint8_t
+    {
+        KEEP,
+        REMOVE,
+        INSERT
+    };
+
+    JsonDiff() = default;
+
+    void diffValue(const Json::JsonFieldValue& from, const Json::JsonFieldValue& to, std::string& path);
+    void diffObjects(const Json::JsonObjectNode& from, const Json::JsonObjectNode& to, std::string& path);
+    void diffLists(const Json::JsonListNode& from, const Json::JsonListNode& to, std::string& path);
+    std::vector<Edit> alignLists(const std::vector<uint64_t>& from, const std::vector<uint64_t>& to) const;
+    void emit(const char* op, const std::string& path, const Json::JsonFieldValue* value);
+
+    Json::JsonListNode patch;
+    Json::HashCache hashes;
+};
+
+} // namespace hk
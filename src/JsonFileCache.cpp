@@ -0,0 +1,168 @@
+#include "JsonFileCache.hpp"
+
+#include "Utility.hpp"
+#include <sys/stat.h>
+
+namespace hk
+{
+
+namespace
+{
+/* Strings this short live inside the std::string itself (libstdc++ small string buffer). */
+constexpr uint64_t INLINE_STRING_CAPACITY{15};
+
+uint64_t stringHeap(const std::string& str)
+{
+    return str.capacity() > INLINE_STRING_CAPACITY ? str.capacity() + 1 : 0;
+}
+
+uint64_t valueHeap(const Json::JsonFieldValue& value);
+
+uint64_t objectHeap(const Json::JsonObjectNode& objNode)
+{
+    /* Each entry is a heap node holding the pair plus the next pointer and the cached key hash. */
+    constexpr uint64_t nodeSize = sizeof(Json::JsonObjectNode::value_type) + 2 * sizeof(void*);
+    uint64_t total = objNode.bucket_count() * sizeof(void*);
+    for (const auto& [key, value] : objNode)
+    {
+        total += nodeSize + stringHeap(key) + valueHeap(value);
+    }
+    return total;
+}
+
+uint64_t listHeap(const Json::JsonListNode& listNode)
+{
+    uint64_t total = listNode.capacity() * sizeof(Json::JsonFieldValue);
+    for (const auto& value : listNode)
+    {
+        total += valueHeap(value);
+    }
+    return total;
+}
+
+uint64_t valueHeap(const Json::JsonFieldValue& value)
+{
+    if (value.isString())
+    {
+        return stringHeap(value.getString());
+    }
+    if (value.isObject())
+    {
+        return objectHeap(value.getObject());
+    }
+    if (value.isList())
+    {
+        return listHeap(value.getList());
+    }
+    return 0;
+}
+} // namespace
+
+JsonFileCache::JsonFileCache(const uint64_t budgetBytes)
+    : budget{budgetBytes}
+{}
+
+JsonFileCache::LoadResult JsonFileCache::load(const std::string& path)
+{
+    struct stat fileStat{};
+    if (stat(path.c_str(), &fileStat) != 0)
+    {
+        std::string errBuff;
+        sprint(errBuff, "Failed to load: %s", path.c_str());
+        return {.json = nullptr, .error = errBuff};
+    }
+
+    const FileIdentity identity{
+        .device = (uint64_t)fileStat.st_dev,
+        .inode = (uint64_t)fileStat.st_ino,
+        .size = (uint64_t)fileStat.st_size,
+        .mtimeNs = (int64_t)fileStat.st_mtim.tv_sec * 1'000'000'000 + fileStat.st_mtim.tv_nsec,
+    };
+
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        const auto it = entries.find(path);
+        if (it != entries.end() && it->second.identity == identity)
+        {
+            hits++;
+            recency.splice(recency.begin(), recency, it->second.recency);
+            return {.json = it->second.json, .error = ""};
+        }
+        misses++;
+    }
+
+    /* Parsed outside the lock, Json instances keep parser state so each load gets its own. */
+    Json json;
+    Json::JsonResult result = json.loadFromFile(path);
+    if (!result.error.empty())
+    {
+        return {.json = nullptr, .error = result.error};
+    }
+
+    std::shared_ptr<const Json::JsonRootNode> document = std::move(result.json);
+    const uint64_t footprint = estimateFootprint(*document);
+
+    std::lock_guard<std::mutex> lock{mutex};
+    evictLocked(path);
+    if (footprint > budget)
+    {
+        return {.json = document, .error = ""};
+    }
+
+    while (bytes + footprint > budget && !recency.empty())
+    {
+        const std::string oldest = recency.back();
+        evictLocked(oldest);
+        evictions++;
+    }
+
+    recency.push_front(path);
+    entries.emplace(path,
+        Entry{.identity = identity, .json = document, .footprint = footprint, .recency = recency.begin()});
+    bytes += footprint;
+    return {.json = document, .error = ""};
+}
+
+void JsonFileCache::invalidate(const std::string& path)
+{
+    std::lock_guard<std::mutex> lock{mutex};
+    evictLocked(path);
+}
+
+void JsonFileCache::clear()
+{
+    std::lock_guard<std::mutex> lock{mutex};
+    entries.clear();
+    recency.clear();
+    bytes = 0;
+}
+
+JsonFileCache::Stats JsonFileCache::getStats() const
+{
+    std::lock_guard<std::mutex> lock{mutex};
+    return {.hits = hits, .misses = misses, .evictions = evictions, .documents = entries.size(), .bytes = bytes};
+}
+
+uint64_t JsonFileCache::estimateFootprint(const Json::JsonRootNode& root)
+{
+    if (std::holds_alternative<Json::JsonObjectNode>(root))
+    {
+        return sizeof(Json::JsonRootNode) + objectHeap(std::get<Json::JsonObjectNode>(root));
+    }
+    return sizeof(Json::JsonRootNode) + listHeap(std::get<Json::JsonListNode>(root));
+}
+
+void JsonFileCache::evictLocked(const std::string& path)
+{
+    const auto it = entries.find(path);
+    if (it == entries.end())
+    {
+        return;
+    }
+
+    bytes -= it->second.footprint;
+    recency.erase(it->second.recency);
+    entries.erase(it);
+}
+
+} // namespace hk
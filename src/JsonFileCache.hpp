@@ -0,0 +1,102 @@
+#pragma once
+
+#include "HkJson.hpp"
+
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace hk
+{
+
+/* Opt-in cache of parsed files, shared by everyone loading the same configs.
+    - A file is parsed again only when stat says it changed: device, inode, size or mtime (nanoseconds) differ.
+      Replacing a file through rename shows up as a new inode even if size and mtime match.
+    - Documents are handed out as shared immutable roots, so callers keep theirs alive after eviction and nobody
+      sees another caller's edits. Copy the root to modify it.
+    - Thread safe. The lock is not held while parsing, two threads missing on the same file both parse it and the
+      last one in wins.
+    - Least recently used documents are evicted past _budget_ bytes, an estimate of the parsed footprint.
+      Documents bigger than the whole budget are returned without being cached. Failed loads are never cached.
+
+    JsonFileCache cache;
+    JsonFileCache::LoadResult config = cache.load("/etc/app/config.json");
+*/
+class JsonFileCache
+{
+public:
+    static constexpr uint64_t DEFAULT_BUDGET{64 * 1024 * 1024};
+
+    struct LoadResult
+    {
+        std::shared_ptr<const Json::JsonRootNode> json;
+        const std::string error;
+    };
+
+    struct Stats
+    {
+        uint64_t hits;
+        uint64_t misses;
+        uint64_t evictions;
+        uint64_t documents;
+        uint64_t bytes;
+    };
+
+    explicit JsonFileCache(const uint64_t budget = DEFAULT_BUDGET);
+
+    /**
+        @brief Cached document for _path_ if the file didn't change since, otherwise parse it with
+            Json::loadFromFile (compressed files included) and remember it.
+    */
+    LoadResult load(const std::string& path);
+
+    /**
+        @brief Forget _path_ / everything. Documents already handed out stay valid.
+    */
+    void invalidate(const std::string& path);
+    void clear();
+
+    Stats getStats() const;
+
+    /**
+        @brief Rough heap footprint of a parsed document, what counts against the budget.
+    */
+    static uint64_t estimateFootprint(const Json::JsonRootNode& root);
+
+private:
+    struct FileIdentity
+    {
+        uint64_t device{0};
+        uint64_t inode{0};
+        uint64_t size{0};
+        int64_t mtimeNs{0};
+
+        bool operator==(const FileIdentity&) const = default;
+    };
+
+    struct Entry
+    {
+        FileIdentity identity;
+        std::shared_ptr<const Json::JsonRootNode> json;
+        uint64_t footprint{0};
+        std::list<std::string>::iterator recency;
+    };
+
+    void evictLocked(const std::string& path);
+
+    const uint64_t budget;
+
+    mutable std::mutex mutex;
+    std::unordered_map<std::string, Entry> entries;
+    /* Most recently used path first. */
+    std::list<std::string> recency;
+    uint64_t bytes{0};
+    uint64_t hits{0};
+    uint64_t misses{0};
+    uint64_t evictions{0};
+};
+
+} // namespace hk
@@ -0,0 +1,356 @@
+#include "JsonIncremental.hpp"
+
+#include <algorithm>
+
+namespace hk
+{
+
+namespace
+{
+Json::JsonRootNode toRootNode(Json::JsonFieldValue&& value)
+{
+    if (value.isObject())
+    {
+        return Json::JsonRootNode{std::move(value.getObject())};
+    }
+    return Json::JsonRootNode{std::move(value.getList())};
+}
+} // namespace
+
+std::string JsonIncremental::parse(const std::string_view text)
+{
+    lastReparsedBytes = text.size();
+
+    JsonReader reader{text};
+    const char first = reader.peekToken();
+    if (first == '\0')
+    {
+        /* Empty text, like Json::loadFromString. */
+        root = Json::JsonRootNode{Json::JsonObjectNode{}};
+        rootSpan = Span{};
+        hasRootSpan = false;
+        return "";
+    }
+    if (first != '{' && first != '[')
+    {
+        reader.fail("Expected '{' or '[' as root");
+        return reader.describeError();
+    }
+
+    Json::JsonFieldValue value;
+    Span span;
+    if (parseValue(reader, value, span, 0) && !reader.isAtEnd())
+    {
+        reader.fail("Unexpected data after the document end");
+    }
+    if (!reader.ok())
+    {
+        return reader.describeError();
+    }
+
+    root = toRootNode(std::move(value));
+    rootSpan = std::move(span);
+    hasRootSpan = true;
+    return "";
+}
+
+std::string JsonIncremental::applyEdit(const std::string_view oldText, const Edit& edit)
+{
+    if (edit.offset > oldText.size() || edit.removed > oldText.size() - edit.offset)
+    {
+        return "Edit out of range";
+    }
+
+    /* Outside the root's brackets (or no root yet): nothing smaller to re-parse than the whole text. */
+    if (!hasRootSpan || edit.offset <= rootSpan.begin ||
+        edit.offset + edit.removed >= rootSpan.begin + rootSpan.length)
+    {
+        std::string text;
+        text.reserve(oldText.size() - edit.removed + edit.inserted.size());
+        text.append(oldText.substr(0, edit.offset));
+        text.append(edit.inserted);
+        text.append(oldText.substr(edit.offset + edit.removed));
+
+        JsonIncremental fresh;
+        const std::string error = fresh.parse(text);
+        lastReparsedBytes = text.size();
+        if (error.empty())
+        {
+            *this = std::move(fresh);
+        }
+        return error;
+    }
+
+    /* Descend into the innermost container holding the edit strictly between its brackets. */
+    std::vector<Span*> path{&rootSpan};
+    std::vector<uint64_t> begins{rootSpan.begin};
+    while (true)
+    {
+        std::vector<Span>& children = path.back()->children;
+        const uint64_t relative = edit.offset - begins.back();
+        auto it = std::upper_bound(children.begin(), children.end(), relative,
+            [](const uint64_t offset, const Span& child) { return offset < child.begin; });
+        if (it == children.begin())
+        {
+            break;
+        }
+        --it;
+        if (relative <= it->begin || relative + edit.removed >= it->begin + it->length)
+        {
+            break;
+        }
+        path.push_back(&*it);
+        begins.push_back(begins.back() + it->begin);
+    }
+
+    const int64_t delta = (int64_t)edit.inserted.size() - (int64_t)edit.removed;
+    std::string slice;
+    for (uint64_t level = path.size(); level-- > 0;)
+    {
+        const uint64_t begin = begins[level];
+        const uint64_t end = begin + path[level]->length;
+        slice.clear();
+        slice.append(oldText.substr(begin, edit.offset - begin));
+        slice.append(edit.inserted);
+        slice.append(oldText.substr(edit.offset + edit.removed, end - edit.offset - edit.removed));
+        lastReparsedBytes = slice.size();
+
+        /* Validating is much cheaper than building, levels that don't hold the edit are skipped without a DOM. */
+        JsonReader checker{slice};
+        if (checker.skipValue(level) && !checker.isAtEnd())
+        {
+            checker.fail("Unexpected data after the document end");
+        }
+        if (!checker.ok())
+        {
+            if (level == 0)
+            {
+                return std::string{checker.getError()} + " at offset " +
+                       std::to_string(begin + checker.getErrorOffset());
+            }
+            continue;
+        }
+
+        JsonReader reader{slice};
+        Json::JsonFieldValue value;
+        Span span;
+        if (!parseValue(reader, value, span, level))
+        {
+            return reader.describeError();
+        }
+        splice(path, level, std::move(value), std::move(span), delta);
+        return "";
+    }
+    return "";
+}
+
+const Json::JsonRootNode& JsonIncremental::getRoot() const
+{
+    return root;
+}
+
+uint64_t JsonIncremental::getLastReparsedBytes() const
+{
+    return lastReparsedBytes;
+}
+
+bool JsonIncremental::parseValue(JsonReader& reader, Json::JsonFieldValue& out, Span& span, const uint32_t depth)
+{
+    if (depth > JsonReader::MAX_DEPTH)
+    {
+        return reader.fail("Document nested too deep");
+    }
+
+    switch (reader.peekToken())
+    {
+        case '{':
+            return parseObject(reader, out, span, depth);
+        case '[':
+            return parseList(reader, out, span, depth);
+        case '"': {
+            std::string str;
+            if (!reader.readString(str))
+            {
+                return false;
+            }
+            out = std::move(str);
+            return true;
+        }
+        case 't':
+            out = true;
+            return reader.readLiteral("true");
+        case 'f':
+            out = false;
+            return reader.readLiteral("false");
+        case 'n':
+            out = Json::JsonNull{};
+            return reader.readLiteral("null");
+        case '\0':
+            return reader.fail("Unexpected end of input");
+        default: {
+            std::string_view raw;
+            bool isInteger{false};
+            if (!reader.readNumber(raw, isInteger))
+            {
+                return false;
+            }
+
+            int64_t integer{0};
+            if (isInteger && JsonReader::toInt64(raw, integer))
+            {
+                out = integer;
+            }
+            else
+            {
+                out = JsonReader::toDouble(raw);
+            }
+            return true;
+        }
+    }
+}
+
+bool JsonIncremental::parseObject(JsonReader& reader, Json::JsonFieldValue& out, Span& span, const uint32_t depth)
+{
+    span.begin = reader.position();
+
+    Json::JsonObjectNode objNode;
+    bool hasMembers{false};
+    reader.enterObject(hasMembers);
+    while (hasMembers)
+    {
+        std::string_view rawKey;
+        bool hasEscapes{false};
+        if (!reader.readKey(rawKey, hasEscapes))
+        {
+            return false;
+        }
+        std::string key;
+        if (hasEscapes)
+        {
+            JsonReader::decodeEscapes(rawKey, key);
+        }
+        else
+        {
+            key.assign(rawKey);
+        }
+
+        Json::JsonFieldValue value;
+        Span child;
+        if (!parseValue(reader, value, child, depth + 1))
+        {
+            return false;
+        }
+
+        /* Last duplicate wins, the span of the one it overwrites must not lead an edit to it. */
+        const auto [it, inserted] = objNode.try_emplace(key);
+        if (!inserted)
+        {
+            std::erase_if(span.children, [&key](const Span& previous) { return previous.key == key; });
+        }
+        if (value.isObject() || value.isList())
+        {
+            child.begin -= span.begin;
+            child.key = key;
+            span.children.push_back(std::move(child));
+        }
+        it->second = std::move(value);
+
+        if (!reader.nextMember(hasMembers))
+        {
+            return false;
+        }
+    }
+    if (!reader.ok())
+    {
+        return false;
+    }
+
+    span.length = reader.position() - span.begin;
+    out = std::move(objNode);
+    return true;
+}
+
+bool JsonIncremental::parseList(JsonReader& reader, Json::JsonFieldValue& out, Span& span, const uint32_t depth)
+{
+    span.begin = reader.position();
+
+    Json::JsonListNode listNode;
+    bool hasElements{false};
+    reader.enterArray(hasElements);
+    while (hasElements)
+    {
+        Json::JsonFieldValue value;
+        Span child;
+        if (!parseValue(reader, value, child, depth + 1))
+        {
+            return false;
+        }
+
+        if (value.isObject() || value.isList())
+        {
+            child.begin -= span.begin;
+            child.index = listNode.size();
+            span.children.push_back(std::move(child));
+        }
+        listNode.emplace_back(std::move(value));
+
+        if (!reader.nextElement(hasElements))
+        {
+            return false;
+        }
+    }
+    if (!reader.ok())
+    {
+        return false;
+    }
+
+    span.length = reader.position() - span.begin;
+    out = std::move(listNode);
+    return true;
+}
+
+void JsonIncremental::splice(const std::vector<Span*>& path, const uint64_t level, Json::JsonFieldValue&& value,
+    Span&& span, const int64_t delta)
+{
+    if (level == 0)
+    {
+        root = toRootNode(std::move(value));
+    }
+    else
+    {
+        /* Walk down to the container being replaced, spans only record keys and indices. */
+        Json::JsonFieldValue* target{nullptr};
+        for (uint64_t i{1}; i <= level; i++)
+        {
+            const Span& step = *path[i];
+            if (i == 1)
+            {
+                target = root.isObject() ? &root.getObject().at(step.key) : &root.getList().at(step.index);
+            }
+            else
+            {
+                target = target->isObject() ? &target->getObject().at(step.key) : &target->getList().at(step.index);
+            }
+        }
+        *target = std::move(value);
+    }
+
+    /* The re-parsed slice starts at the container's opening bracket, its place in the parent doesn't move. */
+    Span& replaced = *path[level];
+    span.begin = replaced.begin;
+    span.key = std::move(replaced.key);
+    span.index = replaced.index;
+    replaced = std::move(span);
+
+    for (uint64_t i{0}; i < level; i++)
+    {
+        Span& ancestor = *path[i];
+        ancestor.length += delta;
+        for (Span* sibling = path[i + 1] + 1; sibling != ancestor.children.data() + ancestor.children.size(); sibling++)
+        {
+            sibling->begin += delta;
+        }
+    }
+}
+
+} // namespace hk
@@ -0,0 +1,83 @@
+#pragma once
+
+#include "HkJson.hpp"
+#include "JsonReader.hpp"
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace hk
+{
+
+/* Document kept in sync with its text through small edits, for editors re-parsing on every keystroke.
+    - Parsing records the source span of every object and list. An edit re-parses only the smallest container
+      whose inside (brackets excluded) contains it, and the new value replaces the old one in the tree.
+    - If that container doesn't parse back into exactly one value over its new span (the edit unbalanced the
+      brackets, or spilled over into a neighbour), the next enclosing container is tried, up to the root.
+    - Spans are stored relative to the parent container, so an edit only shifts the ancestors and the later
+      siblings along its path. The cost follows the size of the re-parsed container, not of the document.
+    - Values are read with JsonReader, the rules of Json::validate: duplicate keys keep the last value, integers
+      that don't fit int64 become doubles. An edit that breaks the document is rejected and changes nothing.
+
+    JsonIncremental doc;
+    doc.parse(text);
+    doc.applyEdit(text, {.offset = 42, .removed = 1, .inserted = "7"});
+    text.replace(42, 1, "7");
+*/
+class JsonIncremental
+{
+public:
+    struct Edit
+    {
+        uint64_t offset{0};
+        uint64_t removed{0};
+        std::string_view inserted;
+    };
+
+    /**
+        @brief Parse the whole _text_. Returns empty string on success, otherwise the error with its offset.
+    */
+    std::string parse(const std::string_view text);
+
+    /**
+        @brief Apply _edit_ to the document parsed from _oldText_ (the text before the edit). The caller applies
+            the same edit to its copy of the text. Returns empty string on success, on error nothing changes.
+    */
+    std::string applyEdit(const std::string_view oldText, const Edit& edit);
+
+    const Json::JsonRootNode& getRoot() const;
+
+    /**
+        @brief Bytes handed to the parser by the last parse/applyEdit.
+    */
+    uint64_t getLastReparsedBytes() const;
+
+private:
+    struct Span
+    {
+        /* Relative to the parent's begin, absolute for the root. */
+        uint64_t begin{0};
+        uint64_t length{0};
+        /* Where the container sits in its parent: key for objects, index for lists. */
+        std::string key;
+        uint64_t index{0};
+        /* Containers directly inside, in text order. */
+        std::vector<Span> children;
+    };
+
+    static bool parseValue(JsonReader& reader, Json::JsonFieldValue& out, Span& span, const uint32_t depth);
+    static bool parseObject(JsonReader& reader, Json::JsonFieldValue& out, Span& span, const uint32_t depth);
+    static bool parseList(JsonReader& reader, Json::JsonFieldValue& out, Span& span, const uint32_t depth);
+
+    void splice(const std::vector<Span*>& path, const uint64_t level, Json::JsonFieldValue&& value, Span&& span,
+        const int64_t delta);
+
+    Json::JsonRootNode root{Json::JsonObjectNode{}};
+    Span rootSpan;
+    bool hasRootSpan{false};
+    uint64_t lastReparsedBytes{0};
+};
+
+} // namespace hk
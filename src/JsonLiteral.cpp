@@ -0,0 +1,59 @@
+#include "JsonLiteral.hpp"
+
+namespace hk
+{
+
+Json::JsonFieldValue JsonLiteralValue::toFieldValue() const
+{
+    if (isBool())
+    {
+        return getBool();
+    }
+    else if (isInt())
+    {
+        return getInt();
+    }
+    else if (isDouble())
+    {
+        return getDouble();
+    }
+    else if (isString())
+    {
+        return std::string{getString()};
+    }
+    else if (isObject())
+    {
+        Json::JsonObjectNode objNode;
+        objNode.reserve(size());
+        for (uint32_t child = index + 1; child < nodes[index].end; child = nodes[child].end)
+        {
+            const JsonLiteralValue value{nodes, pool, child};
+            objNode.insert_or_assign(std::string{pool + nodes[child].keyOffset, nodes[child].keyLength},
+                value.toFieldValue());
+        }
+        return objNode;
+    }
+    else if (isList())
+    {
+        Json::JsonListNode listNode;
+        listNode.reserve(size());
+        for (uint32_t child = index + 1; child < nodes[index].end; child = nodes[child].end)
+        {
+            listNode.emplace_back(JsonLiteralValue{nodes, pool, child}.toFieldValue());
+        }
+        return listNode;
+    }
+    return Json::JsonNull{};
+}
+
+Json::JsonRootNode JsonLiteralValue::toRootNode() const
+{
+    Json::JsonFieldValue rootValue = toFieldValue();
+    if (rootValue.isList())
+    {
+        return Json::JsonRootNode{std::move(rootValue.getList())};
+    }
+    return Json::JsonRootNode{std::move(rootValue.getObject())};
+}
+
+} // namespace hk
@@ -0,0 +1,434 @@
+#pragma once
+
+#include "HkJson.hpp"
+#include "JsonReader.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace hk
+{
+
+/* JSON literals parsed by the compiler instead of at startup.
+    - The text is parsed twice at compile time: once to size the node and string pools, once to fill them.
+      The result is a flat, pre-order node array plus a pool of decoded strings baked into the binary.
+    - A malformed literal fails the build with a static_assert, the note underneath shows the byte offset.
+    - Values can be queried in constant expressions (static_assert(config.root()["port"].getInt() == 8080))
+      or turned into a regular document at runtime with toRootNode().
+
+    constexpr auto& defaults = hk::jsonLiteral<R"({"port": 8080, "hosts": ["a", "b"]})">;
+    Json::JsonRootNode root = defaults.toRootNode();
+*/
+template <uint64_t N> struct JsonFixedString
+{
+    char data[N]{};
+
+    constexpr JsonFixedString(const char (&text)[N])
+    {
+        std::copy_n(text, N, data);
+    }
+
+    constexpr std::string_view view() const
+    {
+        return {data, N - 1};
+    }
+};
+
+struct JsonLiteralNode
+{
+    enum class Type : uint8_t
+    {
+        NULL_VALUE,
+        BOOL,
+        INT,
+        DOUBLE,
+        STRING,
+        OBJECT,
+        LIST
+    };
+
+    Type type{Type::NULL_VALUE};
+    bool boolValue{false};
+    int64_t intValue{0};
+    double doubleValue{0};
+
+    /* String value (or nothing) and key inside the parent object (or nothing), both in the string pool. */
+    uint32_t strOffset{0};
+    uint32_t strLength{0};
+    uint32_t keyOffset{0};
+    uint32_t keyLength{0};
+
+    /* Direct children of objects/lists follow the node, _end_ is the index right after its whole subtree. */
+    uint32_t childCount{0};
+    uint32_t end{0};
+};
+
+class JsonLiteralValue
+{
+public:
+    constexpr JsonLiteralValue() = default;
+    constexpr JsonLiteralValue(const JsonLiteralNode* nodeArray, const char* stringPool, const uint32_t nodeIndex)
+        : nodes{nodeArray}
+        , pool{stringPool}
+        , index{nodeIndex}
+    {}
+
+    /**
+        @brief False for values obtained through a missing key or an out of range index.
+    */
+    constexpr bool exists() const
+    {
+        return nodes != nullptr;
+    }
+
+    constexpr bool isNull() const
+    {
+        return is(JsonLiteralNode::Type::NULL_VALUE);
+    }
+
+    constexpr bool isBool() const
+    {
+        return is(JsonLiteralNode::Type::BOOL);
+    }
+
+    constexpr bool isInt() const
+    {
+        return is(JsonLiteralNode::Type::INT);
+    }
+
+    constexpr bool isDouble() const
+    {
+        return is(JsonLiteralNode::Type::DOUBLE);
+    }
+
+    constexpr bool isString() const
+    {
+        return is(JsonLiteralNode::Type::STRING);
+    }
+
+    constexpr bool isObject() const
+    {
+        return is(JsonLiteralNode::Type::OBJECT);
+    }
+
+    constexpr bool isList() const
+    {
+        return is(JsonLiteralNode::Type::LIST);
+    }
+
+    constexpr bool getBool() const
+    {
+        return isBool() && nodes[index].boolValue;
+    }
+
+    constexpr int64_t getInt() const
+    {
+        return isInt() ? nodes[index].intValue : 0;
+    }
+
+    constexpr double getDouble() const
+    {
+        return isDouble() ? nodes[index].doubleValue : 0;
+    }
+
+    constexpr std::string_view getString() const
+    {
+        return isString() ? std::string_view{pool + nodes[index].strOffset, nodes[index].strLength}
+                          : std::string_view{};
+    }
+
+    /**
+        @brief Number of entries for objects and lists, 0 otherwise.
+    */
+    constexpr uint32_t size() const
+    {
+        return (isObject() || isList()) ? nodes[index].childCount : 0;
+    }
+
+    constexpr JsonLiteralValue operator[](const std::string_view key) const
+    {
+        if (!isObject())
+        {
+            return {};
+        }
+
+        for (uint32_t child = index + 1; child < nodes[index].end; child = nodes[child].end)
+        {
+            if (std::string_view{pool + nodes[child].keyOffset, nodes[child].keyLength} == key)
+            {
+                return {nodes, pool, child};
+            }
+        }
+        return {};
+    }
+
+    constexpr JsonLiteralValue operator[](const uint64_t position) const
+    {
+        return isList() ? valueAt(position) : JsonLiteralValue{};
+    }
+
+    /**
+        @brief Key of the _position_th object entry, in literal order.
+    */
+    constexpr std::string_view keyAt(const uint64_t position) const
+    {
+        const JsonLiteralValue entry = isObject() ? valueAt(position) : JsonLiteralValue{};
+        return entry.exists() ? std::string_view{pool + nodes[entry.index].keyOffset, nodes[entry.index].keyLength}
+                              : std::string_view{};
+    }
+
+    constexpr JsonLiteralValue valueAt(const uint64_t position) const
+    {
+        if (position >= size())
+        {
+            return {};
+        }
+
+        uint32_t child = index + 1;
+        for (uint64_t i{0}; i < position; i++)
+        {
+            child = nodes[child].end;
+        }
+        return {nodes, pool, child};
+    }
+
+    /**
+        @brief Materialize this value (and everything below it) into a DOM value.
+    */
+    Json::JsonFieldValue toFieldValue() const;
+
+    /**
+        @brief Same as toFieldValue for the root object/list, as a regular document.
+    */
+    Json::JsonRootNode toRootNode() const;
+
+private:
+    constexpr bool is(const JsonLiteralNode::Type type) const
+    {
+        return exists() && nodes[index].type == type;
+    }
+
+    const JsonLiteralNode* nodes{nullptr};
+    const char* pool{nullptr};
+    uint32_t index{0};
+};
+
+/* Parser shared by both compile time passes. Without node/pool storage it only measures. */
+class JsonLiteralParser
+{
+public:
+    static constexpr uint32_t NO_ERROR{UINT32_MAX};
+
+    constexpr JsonLiteralParser(const std::string_view text, JsonLiteralNode* nodeArray, char* stringPool)
+        : reader{text}
+        , nodes{nodeArray}
+        , pool{stringPool}
+    {}
+
+    /**
+        @brief Parse the whole literal. Returns NO_ERROR or the byte offset of the first error.
+    */
+    constexpr uint32_t parse()
+    {
+        const char first = reader.peekToken();
+        if (first != '{' && first != '[')
+        {
+            reader.fail("Expected '{' or '[' as root");
+        }
+        else if (parseValue(0, 0, 0) && !reader.isAtEnd())
+        {
+            reader.fail("Unexpected data after the document end");
+        }
+        return reader.ok() ? NO_ERROR : (uint32_t)reader.getErrorOffset();
+    }
+
+    constexpr uint32_t getNodeCount() const
+    {
+        return nodeCount;
+    }
+
+    constexpr uint32_t getPoolSize() const
+    {
+        return poolSize;
+    }
+
+private:
+    constexpr bool parseValue(const uint32_t depth, const uint32_t keyOffset, const uint32_t keyLength)
+    {
+        if (depth > JsonReader::MAX_DEPTH)
+        {
+            return reader.fail("Document nested too deep");
+        }
+
+        const uint32_t index = nodeCount++;
+        JsonLiteralNode node;
+        node.keyOffset = keyOffset;
+        node.keyLength = keyLength;
+
+        bool parsed{false};
+        switch (reader.peekToken())
+        {
+            case '{': {
+                node.type = JsonLiteralNode::Type::OBJECT;
+                bool hasMembers{false};
+                reader.enterObject(hasMembers);
+                while (hasMembers)
+                {
+                    std::string_view rawKey;
+                    bool hasEscapes{false};
+                    if (!reader.readKey(rawKey, hasEscapes))
+                    {
+                        return false;
+                    }
+
+                    const uint32_t childKeyOffset = poolSize;
+                    const uint32_t childKeyLength = appendString(rawKey, hasEscapes);
+                    if (!parseValue(depth + 1, childKeyOffset, childKeyLength) || !reader.nextMember(hasMembers))
+                    {
+                        return false;
+                    }
+                    node.childCount++;
+                }
+                parsed = reader.ok();
+                break;
+            }
+            case '[': {
+                node.type = JsonLiteralNode::Type::LIST;
+                bool hasElements{false};
+                reader.enterArray(hasElements);
+                while (hasElements)
+                {
+                    if (!parseValue(depth + 1, 0, 0) || !reader.nextElement(hasElements))
+                    {
+                        return false;
+                    }
+                    node.childCount++;
+                }
+                parsed = reader.ok();
+                break;
+            }
+            case '"': {
+                std::string_view raw;
+                bool hasEscapes{false};
+                node.type = JsonLiteralNode::Type::STRING;
+                node.strOffset = poolSize;
+                parsed = reader.readRawString(raw, hasEscapes);
+                node.strLength = parsed ? appendString(raw, hasEscapes) : 0;
+                break;
+            }
+            case 't':
+                node.type = JsonLiteralNode::Type::BOOL;
+                node.boolValue = true;
+                parsed = reader.readLiteral("true");
+                break;
+            case 'f':
+                node.type = JsonLiteralNode::Type::BOOL;
+                parsed = reader.readLiteral("false");
+                break;
+            case 'n':
+                parsed = reader.readLiteral("null");
+                break;
+            default: {
+                std::string_view raw;
+                bool isInteger{false};
+                parsed = reader.readNumber(raw, isInteger);
+                if (parsed && isInteger && JsonReader::toInt64(raw, node.intValue))
+                {
+                    node.type = JsonLiteralNode::Type::INT;
+                }
+                else if (parsed)
+                {
+                    node.type = JsonLiteralNode::Type::DOUBLE;
+                    node.doubleValue = JsonReader::toDouble(raw);
+                }
+                break;
+            }
+        }
+
+        node.end = nodeCount;
+        if (nodes != nullptr)
+        {
+            nodes[index] = node;
+        }
+        return parsed;
+    }
+
+    /**
+        @brief Decode _raw_ into the pool (or only measure it). Returns the decoded length.
+    */
+    constexpr uint32_t appendString(const std::string_view raw, const bool hasEscapes)
+    {
+        std::string decoded;
+        if (hasEscapes)
+        {
+            JsonReader::decodeEscapes(raw, decoded);
+        }
+        const std::string_view text = hasEscapes ? std::string_view{decoded} : raw;
+
+        if (pool != nullptr)
+        {
+            std::copy(text.begin(), text.end(), pool + poolSize);
+        }
+        poolSize += text.size();
+        return text.size();
+    }
+
+    JsonReader reader;
+    JsonLiteralNode* nodes{nullptr};
+    char* pool{nullptr};
+    uint32_t nodeCount{0};
+    uint32_t poolSize{0};
+};
+
+template <uint32_t NodeCount, uint32_t PoolSize> struct JsonLiteralDocument
+{
+    std::array<JsonLiteralNode, NodeCount> nodes{};
+    std::array<char, PoolSize> pool{};
+
+    constexpr JsonLiteralValue root() const
+    {
+        return {nodes.data(), pool.data(), 0};
+    }
+
+    /**
+        @brief Build a regular document from the literal. Only allocation is left to do, nothing is parsed.
+    */
+    Json::JsonRootNode toRootNode() const
+    {
+        return root().toRootNode();
+    }
+};
+
+template <JsonFixedString Text> struct JsonLiteral
+{
+    struct Layout
+    {
+        uint32_t errorOffset{JsonLiteralParser::NO_ERROR};
+        uint32_t nodeCount{0};
+        uint32_t poolSize{0};
+    };
+
+    static constexpr Layout LAYOUT = []()
+    {
+        JsonLiteralParser parser{Text.view(), nullptr, nullptr};
+        const uint32_t errorOffset = parser.parse();
+        return Layout{errorOffset, parser.getNodeCount(), parser.getPoolSize()};
+    }();
+
+    static_assert(LAYOUT.errorOffset == JsonLiteralParser::NO_ERROR, "Malformed JSON literal, see errorOffset");
+
+    static constexpr JsonLiteralDocument<LAYOUT.nodeCount, LAYOUT.poolSize> document = []()
+    {
+        JsonLiteralDocument<LAYOUT.nodeCount, LAYOUT.poolSize> result;
+        JsonLiteralParser parser{Text.view(), result.nodes.data(), result.pool.data()};
+        parser.parse();
+        return result;
+    }();
+};
+
+template <JsonFixedString Text> inline constexpr const auto& jsonLiteral = JsonLiteral<Text>::document;
+
+} // namespace hk
@@ -0,0 +1,561 @@
+#include "JsonPatch.hpp"
+
+#include "Utility.hpp"
+#include <algorithm>
+#include <utility>
+
+namespace hk
+{
+
+namespace
+{
+/* Direct parent of the value a pointer refers to: exactly one of the two is set. */
+struct Parent
+{
+    Json::JsonObjectNode* object{nullptr};
+    Json::JsonListNode* list{nullptr};
+};
+
+/**
+    @brief RFC 6901 array index: digits only, no leading zeros. "-" is left to the callers that accept it.
+*/
+bool parseIndex(const std::string& token, uint64_t& index)
+{
+    if (token.empty() || token.size() > 18 || (token.size() > 1 && token[0] == '0'))
+    {
+        return false;
+    }
+
+    index = 0;
+    for (const char ch : token)
+    {
+        if (ch < '0' || ch > '9')
+        {
+            return false;
+        }
+        index = index * 10 + (ch - '0');
+    }
+    return true;
+}
+
+Json::JsonFieldValue* childOf(const Parent& parent, const std::string& token)
+{
+    if (parent.object != nullptr)
+    {
+        const auto it = parent.object->find(token);
+        return it != parent.object->end() ? &it->second : nullptr;
+    }
+
+    uint64_t index{0};
+    return parseIndex(token, index) && index < parent.list->size() ? &(*parent.list)[index] : nullptr;
+}
+
+/**
+    @brief Walk every token but the last one. Returns false if a step is missing or isn't a container.
+*/
+bool findParent(Json::JsonRootNode& root, const JsonPatch::Pointer& path, Parent& parent)
+{
+    parent = root.isObject() ? Parent{&root.getObject(), nullptr} : Parent{nullptr, &root.getList()};
+    for (uint64_t i{0}; i + 1 < path.size(); i++)
+    {
+        Json::JsonFieldValue* child = childOf(parent, path[i]);
+        if (child == nullptr || !(child->isObject() || child->isList()))
+        {
+            return false;
+        }
+        parent = child->isObject() ? Parent{&child->getObject(), nullptr} : Parent{nullptr, &child->getList()};
+    }
+    return true;
+}
+
+/* The root is a JsonRootNode and not a field value, these move it across without copying. */
+Json::JsonFieldValue takeRoot(Json::JsonRootNode& root)
+{
+    Json::JsonFieldValue value;
+    if (root.isObject())
+    {
+        value = std::move(root.getObject());
+    }
+    else
+    {
+        value = std::move(root.getList());
+    }
+    root.emplace<Json::JsonObjectNode>();
+    return value;
+}
+
+void putRoot(Json::JsonRootNode& root, Json::JsonFieldValue&& value)
+{
+    if (value.isObject())
+    {
+        root.emplace<Json::JsonObjectNode>(std::move(value.getObject()));
+    }
+    else
+    {
+        root.emplace<Json::JsonListNode>(std::move(value.getList()));
+    }
+}
+} // namespace
+
+struct JsonPatch::Applier
+{
+    enum class UndoKind : uint8_t
+    {
+        /* Undo: take the value at _path_ away, put _displaced_ back there if there was one. */
+        INSERTED,
+        /* Undo: put _displaced_ back at _path_. */
+        REMOVED,
+        /* Undo: take the value at _path_ away, put _displaced_ back if any, then put the value back at _from_. */
+        MOVED
+    };
+
+    struct UndoEntry
+    {
+        UndoKind kind{UndoKind::INSERTED};
+        Pointer path{};
+        Pointer from{};
+        bool hasDisplaced{false};
+        Json::JsonFieldValue displaced{};
+    };
+
+    Json::JsonRootNode& root;
+    std::vector<UndoEntry> undoLog;
+
+    /**
+        @brief Insert _value_ at _path_: new object key, shifted array element or whole root. A value already
+            sitting under that key (or the old root) is moved into _displaced_. "-" in _path_ is replaced with
+            the index actually used.
+    */
+    const char* put(Pointer& path, Json::JsonFieldValue&& value, bool& hasDisplaced, Json::JsonFieldValue& displaced)
+    {
+        hasDisplaced = false;
+        if (path.empty())
+        {
+            if (!value.isObject() && !value.isList())
+            {
+                return "the document root can only be an object or an array";
+            }
+            displaced = takeRoot(root);
+            hasDisplaced = true;
+            putRoot(root, std::move(value));
+            return nullptr;
+        }
+
+        Parent parent;
+        if (!findParent(root, path, parent))
+        {
+            return "parent of the target location doesn't exist";
+        }
+
+        std::string& token = path.back();
+        if (parent.object != nullptr)
+        {
+            const auto [it, inserted] = parent.object->try_emplace(token);
+            if (!inserted)
+            {
+                displaced = std::move(it->second);
+                hasDisplaced = true;
+            }
+            it->second = std::move(value);
+            return nullptr;
+        }
+
+        uint64_t index{parent.list->size()};
+        if (token != "-" && (!parseIndex(token, index) || index > parent.list->size()))
+        {
+            return "array index is invalid or out of bounds";
+        }
+        parent.list->insert(parent.list->begin() + index, std::move(value));
+        token = std::to_string(index);
+        return nullptr;
+    }
+
+    /**
+        @brief Move the value at _path_ out of the document into _out_, removing its key/element.
+    */
+    const char* take(const Pointer& path, Json::JsonFieldValue& out)
+    {
+        if (path.empty())
+        {
+            out = takeRoot(root);
+            return nullptr;
+        }
+
+        Parent parent;
+        if (!findParent(root, path, parent))
+        {
+            return "path doesn't exist";
+        }
+
+        if (parent.object != nullptr)
+        {
+            const auto it = parent.object->find(path.back());
+            if (it == parent.object->end())
+            {
+                return "path doesn't exist";
+            }
+            out = std::move(it->second);
+            parent.object->erase(it);
+            return nullptr;
+        }
+
+        uint64_t index{0};
+        if (!parseIndex(path.back(), index) || index >= parent.list->size())
+        {
+            return "array index is invalid or out of bounds";
+        }
+        out = std::move((*parent.list)[index]);
+        parent.list->erase(parent.list->begin() + index);
+        return nullptr;
+    }
+
+    /**
+        @brief Existing value at a non empty _path_, nullptr if missing.
+    */
+    Json::JsonFieldValue* get(const Pointer& path)
+    {
+        Parent parent;
+        return findParent(root, path, parent) ? childOf(parent, path.back()) : nullptr;
+    }
+
+    const char* add(Pointer& path, Json::JsonFieldValue&& value)
+    {
+        UndoEntry entry{.kind = UndoKind::INSERTED};
+        const char* error = put(path, std::move(value), entry.hasDisplaced, entry.displaced);
+        if (error == nullptr)
+        {
+            entry.path = std::move(path);
+            undoLog.emplace_back(std::move(entry));
+        }
+        return error;
+    }
+
+    const char* remove(Pointer& path)
+    {
+        if (path.empty())
+        {
+            return "the document root can't be removed";
+        }
+
+        UndoEntry entry{.kind = UndoKind::REMOVED, .hasDisplaced = true};
+        const char* error = take(path, entry.displaced);
+        if (error == nullptr)
+        {
+            entry.path = std::move(path);
+            undoLog.emplace_back(std::move(entry));
+        }
+        return error;
+    }
+
+    const char* replace(Pointer& path, Json::JsonFieldValue&& value)
+    {
+        UndoEntry entry{.kind = UndoKind::INSERTED, .hasDisplaced = true};
+        if (path.empty())
+        {
+            if (!value.isObject() && !value.isList())
+            {
+                return "the document root can only be an object or an array";
+            }
+            entry.displaced = takeRoot(root);
+            putRoot(root, std::move(value));
+        }
+        else
+        {
+            /* Swapped in place, array elements don't shift. */
+            Json::JsonFieldValue* target = get(path);
+            if (target == nullptr)
+            {
+                return "path doesn't exist";
+            }
+            entry.displaced = std::move(*target);
+            *target = std::move(value);
+        }
+
+        entry.path = std::move(path);
+        undoLog.emplace_back(std::move(entry));
+        return nullptr;
+    }
+
+    const char* move(Pointer& from, Pointer& path)
+    {
+        if (from == path)
+        {
+            return get(path) != nullptr || path.empty() ? nullptr : "path doesn't exist";
+        }
+        if (from.size() < path.size() && std::equal(from.begin(), from.end(), path.begin()))
+        {
+            return "a value can't be moved into one of its own children";
+        }
+
+        Json::JsonFieldValue value;
+        const char* error = take(from, value);
+        if (error != nullptr)
+        {
+            return error;
+        }
+
+        UndoEntry entry{.kind = UndoKind::MOVED};
+        error = put(path, std::move(value), entry.hasDisplaced, entry.displaced);
+        if (error != nullptr)
+        {
+            /* put leaves _value_ alone when it fails, hand it back. */
+            bool hasDisplaced{false};
+            Json::JsonFieldValue displaced;
+            put(from, std::move(value), hasDisplaced, displaced);
+            return error;
+        }
+
+        entry.path = std::move(path);
+        entry.from = std::move(from);
+        undoLog.emplace_back(std::move(entry));
+        return nullptr;
+    }
+
+    const char* copy(const Pointer& from, Pointer& path)
+    {
+        Json::JsonFieldValue value;
+        if (from.empty())
+        {
+            value = takeRoot(root);
+            Json::JsonFieldValue duplicate = value;
+            putRoot(root, std::move(value));
+            return add(path, std::move(duplicate));
+        }
+
+        const Json::JsonFieldValue* source = get(from);
+        if (source == nullptr)
+        {
+            return "from path doesn't exist";
+        }
+        return add(path, Json::JsonFieldValue{*source});
+    }
+
+    const char* test(const Pointer& path, const Json::JsonFieldValue& expected)
+    {
+        if (path.empty())
+        {
+            Json::JsonFieldValue rootValue = takeRoot(root);
+            const bool equal = Json::valuesEqual(rootValue, expected);
+            putRoot(root, std::move(rootValue));
+            return equal ? nullptr : "test failed, values differ";
+        }
+
+        const Json::JsonFieldValue* actual = get(path);
+        if (actual == nullptr)
+        {
+            return "path doesn't exist";
+        }
+        return Json::valuesEqual(*actual, expected) ? nullptr : "test failed, values differ";
+    }
+
+    void rollback()
+    {
+        for (auto it = undoLog.rbegin(); it != undoLog.rend(); ++it)
+        {
+            bool hasDisplaced{false};
+            Json::JsonFieldValue ignored;
+            Json::JsonFieldValue value;
+            if (it->kind != UndoKind::REMOVED)
+            {
+                take(it->path, value);
+            }
+            if (it->hasDisplaced)
+            {
+                put(it->path, std::move(it->displaced), hasDisplaced, ignored);
+            }
+            if (it->kind == UndoKind::MOVED)
+            {
+                put(it->from, std::move(value), hasDisplaced, ignored);
+            }
+        }
+        undoLog.clear();
+    }
+};
+
+std::string JsonPatch::apply(Json::JsonRootNode& root, const Json::JsonListNode& patch)
+{
+    Applier applier{.root = root, .undoLog = {}};
+    applier.undoLog.reserve(patch.size());
+
+    for (uint64_t i{0}; i < patch.size(); i++)
+    {
+        const Json::JsonFieldValue& operation = patch[i];
+        std::string opName = "?";
+        std::string reason;
+
+        const auto field = [&operation](const std::string& name) -> const Json::JsonFieldValue*
+        {
+            const auto it = operation.getObject().find(name);
+            return it != operation.getObject().end() ? &it->second : nullptr;
+        };
+
+        if (!operation.isObject())
+        {
+            reason = "operation must be an object";
+        }
+        else
+        {
+            const Json::JsonFieldValue* op = field("op");
+            const Json::JsonFieldValue* pathField = field("path");
+            const Json::JsonFieldValue* fromField = field("from");
+            const Json::JsonFieldValue* value = field("value");
+            opName = op != nullptr && op->isString() ? op->getString() : opName;
+
+            Pointer path;
+            Pointer from;
+            const bool needsFrom = opName == "move" || opName == "copy";
+            const bool needsValue = opName == "add" || opName == "replace" || opName == "test";
+            if (op == nullptr || !op->isString())
+            {
+                reason = "missing \"op\"";
+            }
+            else if (pathField == nullptr || !pathField->isString())
+            {
+                reason = "missing \"path\"";
+            }
+            else if (needsFrom && (fromField == nullptr || !fromField->isString()))
+            {
+                reason = "missing \"from\"";
+            }
+            else if (needsValue && value == nullptr)
+            {
+                reason = "missing \"value\"";
+            }
+            else
+            {
+                reason = parsePointer(pathField->getString(), path);
+                if (reason.empty() && needsFrom)
+                {
+                    reason = parsePointer(fromField->getString(), from);
+                }
+            }
+
+            if (reason.empty())
+            {
+                const char* error{"unknown operation"};
+                if (opName == "add")
+                {
+                    error = applier.add(path, Json::JsonFieldValue{*value});
+                }
+                else if (opName == "remove")
+                {
+                    error = applier.remove(path);
+                }
+                else if (opName == "replace")
+                {
+                    error = applier.replace(path, Json::JsonFieldValue{*value});
+                }
+                else if (opName == "move")
+                {
+                    error = applier.move(from, path);
+                }
+                else if (opName == "copy")
+                {
+                    error = applier.copy(from, path);
+                }
+                else if (opName == "test")
+                {
+                    error = applier.test(path, *value);
+                }
+                reason = error != nullptr ? error : "";
+            }
+        }
+
+        if (!reason.empty())
+        {
+            applier.rollback();
+            std::string errBuff;
+            sprint(errBuff, "operation %lu (%s): %s", i, opName.c_str(), reason.c_str());
+            return errBuff;
+        }
+    }
+    return "";
+}
+
+std::string JsonPatch::apply(Json::JsonRootNode& root, const Json::JsonRootNode& patch)
+{
+    if (!std::holds_alternative<Json::JsonListNode>(patch))
+    {
+        return "patch must be an array of operations";
+    }
+    return apply(root, std::get<Json::JsonListNode>(patch));
+}
+
+std::string JsonPatch::parsePointer(const std::string_view pointer, Pointer& tokens)
+{
+    tokens.clear();
+    if (pointer.empty())
+    {
+        return "";
+    }
+    if (pointer[0] != '/')
+    {
+        return "pointer must be empty or start with '/'";
+    }
+
+    for (uint64_t i{1}; i <= pointer.size(); i++)
+    {
+        if (pointer[i - 1] == '/')
+        {
+            tokens.emplace_back();
+        }
+        if (i == pointer.size())
+        {
+            break;
+        }
+
+        const char ch = pointer[i];
+        if (ch == '/')
+        {
+            continue;
+        }
+        if (ch != '~')
+        {
+            tokens.back() += ch;
+            continue;
+        }
+
+        /* ~0 is '~' and ~1 is '/', nothing else may follow a '~'. */
+        if (i + 1 >= pointer.size() || (pointer[i + 1] != '0' && pointer[i + 1] != '1'))
+        {
+            return "'~' must be followed by '0' or '1' in pointer";
+        }
+        tokens.back() += pointer[i + 1] == '0' ? '~' : '/';
+        i++;
+    }
+    return "";
+}
+
+void JsonPatch::appendPointerToken(std::string& path, const std::string_view token)
+{
+    path += '/';
+    for (const char ch : token)
+    {
+        if (ch == '~')
+        {
+            path += "~0";
+        }
+        else if (ch == '/')
+        {
+            path += "~1";
+        }
+        else
+        {
+            path += ch;
+        }
+    }
+}
+
+Json::JsonFieldValue* JsonPatch::find(Json::JsonRootNode& root, const std::string_view pointer)
+{
+    Pointer path;
+    if (!parsePointer(pointer, path).empty() || path.empty())
+    {
+        return nullptr;
+    }
+
+    Parent parent;
+    return findParent(root, path, parent) ? childOf(parent, path.back()) : nullptr;
+}
+
+} // namespace hk
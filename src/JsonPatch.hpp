@@ -0,0 +1,53 @@
+#pragma once
+
+#include "HkJson.hpp"
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace hk
+{
+
+/* RFC 6902 JSON Patch applied in place.
+    - Each operation walks its pointer and touches a single entry, so the cost follows the patch and not the
+      document. Moved values change owner without being copied, only "copy" duplicates a subtree.
+    - All or nothing: every change records how to undo itself. When an operation fails (or a "test" doesn't hold)
+      the log is replayed backwards and the document ends up exactly as it was. No snapshot is taken.
+    - Array indices follow the RFC: decimal without leading zeros, "-" appends.
+
+    std::string error = JsonPatch::apply(*state.json, *json.loadFromString(patchText).json);
+*/
+class JsonPatch
+{
+public:
+    using Pointer = std::vector<std::string>;
+
+    /**
+        @brief Apply _patch_, an array of operation objects, to _root_. Returns empty string on success, otherwise
+            "operation N (op): reason" and _root_ is left untouched.
+    */
+    static std::string apply(Json::JsonRootNode& root, const Json::JsonListNode& patch);
+    static std::string apply(Json::JsonRootNode& root, const Json::JsonRootNode& patch);
+
+    /**
+        @brief Split an RFC 6901 pointer into its unescaped reference tokens. Returns empty string on success.
+    */
+    static std::string parsePointer(const std::string_view pointer, Pointer& tokens);
+
+    /**
+        @brief Append _token_ to _path_ as one more reference token, escaping '~' and '/'.
+    */
+    static void appendPointerToken(std::string& path, const std::string_view token);
+
+    /**
+        @brief Value at _pointer_, nullptr if it doesn't exist. The root isn't a field value, "" gives nullptr too.
+    */
+    static Json::JsonFieldValue* find(Json::JsonRootNode& root, const std::string_view pointer);
+
+private:
+    struct Applier;
+};
+
+} // namespace hk
@@ -0,0 +1,746 @@
+#pragma once
+
+#include "SimdScan.hpp"
+
+#include <array>
+#include <charconv>
+#include <cstdint>
+#include <cstdlib>
+#include <limits>
+#include <string>
+#include <string_view>
+
+namespace hk
+{
+
+/* Pull style tokenizer over an in memory JSON text, no DOM involved.
+    - Everything is constexpr so the same code can run at compile time over string literals.
+    - The first error wins: it's kept together with the byte offset where it happened and every
+      following call keeps failing.
+    - Strings come out raw (escapes untouched) through readRawString, or decoded through readString.
+      Either way their bytes are checked to be valid UTF-8 unless setUtf8Validation(false) was called.
+
+    bool hasMembers{false};
+    reader.enterObject(hasMembers);
+    while (hasMembers)
+    {
+        reader.readKey(key, escaped);
+        reader.skipValue();
+        reader.nextMember(hasMembers);
+    }
+*/
+class JsonReader
+{
+public:
+    static constexpr uint32_t MAX_DEPTH{512};
+
+    constexpr explicit JsonReader(const std::string_view input)
+        : data{input}
+    {}
+
+    constexpr bool ok() const
+    {
+        return error == nullptr;
+    }
+
+    constexpr const char* getError() const
+    {
+        return error;
+    }
+
+    constexpr uint64_t getErrorOffset() const
+    {
+        return errorOffset;
+    }
+
+    constexpr uint64_t position() const
+    {
+        return pos;
+    }
+
+    /**
+        @brief Strings are checked for valid UTF-8 by default, _enabled_ = false trusts them as they are.
+    */
+    constexpr void setUtf8Validation(const bool enabled)
+    {
+        utf8Validation = enabled;
+    }
+
+    constexpr std::string_view input() const
+    {
+        return data;
+    }
+
+    /**
+        @brief Error message with its offset appended, empty string if there's no error.
+    */
+    std::string describeError() const
+    {
+        if (error == nullptr)
+        {
+            return "";
+        }
+        return std::string{error} + " at offset " + std::to_string(errorOffset);
+    }
+
+    /**
+        @brief Record _message_ at the current offset (unless an error is already recorded). Always returns false.
+    */
+    constexpr bool fail(const char* message)
+    {
+        if (error == nullptr)
+        {
+            error = message;
+            errorOffset = pos;
+        }
+        pos = data.size();
+        return false;
+    }
+
+    constexpr void skipWhitespace()
+    {
+        if !consteval
+        {
+            /* Compact input has no whitespace at all, only pretty printed indentation is worth scanning. */
+            if (pos + 1 < data.size() && isWhitespace(data[pos]) && isWhitespace(data[pos + 1]))
+            {
+                pos += simd::findNonWhitespace(data.data() + pos, data.size() - pos);
+            }
+        }
+
+        while (pos < data.size() && isWhitespace(data[pos]))
+        {
+            pos++;
+        }
+    }
+
+    /**
+        @brief Next significant char without consuming it, '\0' at the end of input.
+    */
+    constexpr char peekToken()
+    {
+        skipWhitespace();
+        return pos < data.size() ? data[pos] : '\0';
+    }
+
+    constexpr bool isAtEnd()
+    {
+        skipWhitespace();
+        return pos == data.size();
+    }
+
+    constexpr bool expect(const char ch, const char* message)
+    {
+        if (peekToken() != ch)
+        {
+            return fail(message);
+        }
+        pos++;
+        return true;
+    }
+
+    constexpr bool enterObject(bool& hasMembers)
+    {
+        return enterContainer('{', '}', "Expected '{'", hasMembers);
+    }
+
+    constexpr bool nextMember(bool& hasMore)
+    {
+        return nextInContainer('}', "Expected ',' or '}' after object member", hasMore);
+    }
+
+    constexpr bool enterArray(bool& hasElements)
+    {
+        return enterContainer('[', ']', "Expected '['", hasElements);
+    }
+
+    constexpr bool nextElement(bool& hasMore)
+    {
+        return nextInContainer(']', "Expected ',' or ']' after array element", hasMore);
+    }
+
+    /**
+        @brief Read an object key and the ':' after it. _raw_ is the undecoded text between the quotes.
+    */
+    constexpr bool readKey(std::string_view& raw, bool& hasEscapes)
+    {
+        if (peekToken() != '"')
+        {
+            return fail("Object key must be a string");
+        }
+        return readRawString(raw, hasEscapes) && expect(':', "Expected ':' after object key");
+    }
+
+    /**
+        @brief Read a string token, validating escapes but leaving them encoded in _raw_.
+    */
+    constexpr bool readRawString(std::string_view& raw, bool& hasEscapes)
+    {
+        if (peekToken() != '"')
+        {
+            return fail("Expected string");
+        }
+
+        pos++;
+        const uint64_t start = pos;
+        hasEscapes = false;
+        while (pos < data.size())
+        {
+            /* Plain runs are most of a string body, at runtime the vector scan jumps straight to their end. */
+            if !consteval
+            {
+                pos += simd::findEscapable(data.data() + pos, data.size() - pos);
+                if (pos == data.size())
+                {
+                    break;
+                }
+            }
+
+            const uint8_t ch = data[pos];
+            if (ch == '"')
+            {
+                raw = data.substr(start, pos - start);
+                const uint64_t invalidAt = utf8Validation ? findInvalidUtf8(raw) : raw.size();
+                if (invalidAt != raw.size())
+                {
+                    pos = start + invalidAt;
+                    return fail("Invalid UTF-8 in string");
+                }
+                pos++;
+                return true;
+            }
+            else if (ch == '\\')
+            {
+                hasEscapes = true;
+                if (!skipEscape())
+                {
+                    return false;
+                }
+            }
+            else if (ch < 0x20)
+            {
+                return fail("Unescaped control character in string");
+            }
+            else
+            {
+                pos++;
+            }
+        }
+        return fail("Unterminated string");
+    }
+
+    /**
+        @brief Read a string token and decode its escapes into _out_.
+    */
+    constexpr bool readString(std::string& out)
+    {
+        std::string_view raw;
+        bool hasEscapes{false};
+        if (!readRawString(raw, hasEscapes))
+        {
+            return false;
+        }
+
+        out.clear();
+        if (!hasEscapes)
+        {
+            out.append(raw);
+            return true;
+        }
+        decodeEscapes(raw, out);
+        return true;
+    }
+
+    /**
+        @brief Read a number token following the JSON grammar. _isInteger_ is false if it has a fraction or exponent.
+    */
+    constexpr bool readNumber(std::string_view& raw, bool& isInteger)
+    {
+        skipWhitespace();
+        const uint64_t start = pos;
+        isInteger = true;
+
+        if (pos < data.size() && data[pos] == '-')
+        {
+            pos++;
+        }
+
+        if (pos < data.size() && data[pos] == '0')
+        {
+            pos++;
+        }
+        else if (!skipDigits())
+        {
+            return fail("Invalid number");
+        }
+
+        if (pos < data.size() && data[pos] == '.')
+        {
+            pos++;
+            isInteger = false;
+            if (!skipDigits())
+            {
+                return fail("Expected digits after decimal point");
+            }
+        }
+
+        if (pos < data.size() && (data[pos] == 'e' || data[pos] == 'E'))
+        {
+            pos++;
+            isInteger = false;
+            if (pos < data.size() && (data[pos] == '+' || data[pos] == '-'))
+            {
+                pos++;
+            }
+            if (!skipDigits())
+            {
+                return fail("Expected digits in exponent");
+            }
+        }
+
+        raw = data.substr(start, pos - start);
+        return true;
+    }
+
+    /**
+        @brief Consume _literal_ (true, false or null) if it's next.
+    */
+    constexpr bool readLiteral(const std::string_view literal)
+    {
+        skipWhitespace();
+        if (data.substr(pos, literal.size()) != literal)
+        {
+            return fail("Invalid literal");
+        }
+        pos += literal.size();
+        return true;
+    }
+
+    /**
+        @brief Validate and skip whatever value comes next, containers included.
+    */
+    constexpr bool skipValue(const uint32_t depth = 0)
+    {
+        if (depth > MAX_DEPTH)
+        {
+            return fail("Document nested too deep");
+        }
+
+        switch (peekToken())
+        {
+            case '{': {
+                bool hasMembers{false};
+                enterObject(hasMembers);
+                while (hasMembers)
+                {
+                    std::string_view key;
+                    bool hasEscapes{false};
+                    if (!readKey(key, hasEscapes) || !skipValue(depth + 1) || !nextMember(hasMembers))
+                    {
+                        return false;
+                    }
+                }
+                return ok();
+            }
+            case '[': {
+                bool hasElements{false};
+                enterArray(hasElements);
+                while (hasElements)
+                {
+                    if (!skipValue(depth + 1) || !nextElement(hasElements))
+                    {
+                        return false;
+                    }
+                }
+                return ok();
+            }
+            case '"': {
+                std::string_view raw;
+                bool hasEscapes{false};
+                return readRawString(raw, hasEscapes);
+            }
+            case 't':
+                return readLiteral("true");
+            case 'f':
+                return readLiteral("false");
+            case 'n':
+                return readLiteral("null");
+            case '\0':
+                return fail("Unexpected end of input");
+            default: {
+                std::string_view raw;
+                bool isInteger{false};
+                return readNumber(raw, isInteger);
+            }
+        }
+    }
+
+    /**
+        @brief Convert an integer token from readNumber. False if it doesn't fit in int64.
+    */
+    static constexpr bool toInt64(const std::string_view raw, int64_t& out)
+    {
+        const bool negative = !raw.empty() && raw[0] == '-';
+        uint64_t magnitude{0};
+        for (uint64_t i = negative ? 1 : 0; i < raw.size(); i++)
+        {
+            const uint64_t digit = raw[i] - '0';
+            if (magnitude > (UINT64_MAX - digit) / 10)
+            {
+                return false;
+            }
+            magnitude = magnitude * 10 + digit;
+        }
+
+        if (negative ? magnitude > (uint64_t)INT64_MAX + 1 : magnitude > (uint64_t)INT64_MAX)
+        {
+            return false;
+        }
+        out = negative ? (int64_t)(0 - magnitude) : (int64_t)magnitude;
+        return true;
+    }
+
+    /**
+        @brief Convert a number token from readNumber. Correctly rounded at runtime, see toDoubleConstant for
+            the compile time path.
+    */
+    static constexpr double toDouble(const std::string_view raw)
+    {
+        if consteval
+        {
+            return toDoubleConstant(raw);
+        }
+
+        double value{0};
+        const auto result = std::from_chars(raw.data(), raw.data() + raw.size(), value);
+
+        /* from_chars leaves the value untouched on overflow/underflow, strtod saturates to inf/0 like the DOM. */
+        if (result.ec == std::errc::result_out_of_range)
+        {
+            return std::strtod(std::string{raw}.c_str(), nullptr);
+        }
+        return value;
+    }
+
+    /**
+        @brief Compile time number conversion, from_chars isn't constexpr for doubles yet.
+            Exact when the significant digits fit in 53 bits and the decimal exponent is within +-22
+            (1.5, 0.25, 2e10, 999.99...). Past that it goes through long double and the last bit may differ.
+    */
+    static constexpr double toDoubleConstant(const std::string_view raw)
+    {
+        constexpr double EXACT_POWERS[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+            1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+
+        uint64_t i{0};
+        const bool negative = !raw.empty() && raw[0] == '-';
+        i += negative;
+
+        uint64_t mantissa{0};
+        int64_t exponent{0};
+        uint32_t digits{0};
+        bool inFraction{false};
+        for (; i < raw.size() && raw[i] != 'e' && raw[i] != 'E'; i++)
+        {
+            if (raw[i] == '.')
+            {
+                inFraction = true;
+                continue;
+            }
+
+            /* 19 digits always fit in uint64, the rest only shifts the exponent. */
+            if (digits < 19)
+            {
+                mantissa = mantissa * 10 + (raw[i] - '0');
+                digits += mantissa != 0;
+                exponent -= inFraction;
+            }
+            else
+            {
+                exponent += !inFraction;
+            }
+        }
+
+        if (i < raw.size())
+        {
+            i++;
+            const bool negativeExp = raw[i] == '-';
+            i += raw[i] == '-' || raw[i] == '+';
+            int64_t explicitExp{0};
+            for (; i < raw.size() && explicitExp < 100000; i++)
+            {
+                explicitExp = explicitExp * 10 + (raw[i] - '0');
+            }
+            exponent += negativeExp ? -explicitExp : explicitExp;
+        }
+
+        double value{0};
+        if (mantissa == 0 || exponent < -400)
+        {
+            value = 0;
+        }
+        else if (exponent > 400)
+        {
+            value = std::numeric_limits<double>::infinity();
+        }
+        else if (mantissa <= (1ull << 53) && exponent >= -22 && exponent <= 22)
+        {
+            value = exponent < 0 ? (double)mantissa / EXACT_POWERS[-exponent]
+                                 : (double)mantissa * EXACT_POWERS[exponent];
+        }
+        else
+        {
+            long double wide = mantissa;
+            for (; exponent > 0; exponent--)
+            {
+                wide *= 10;
+            }
+            for (; exponent < 0; exponent++)
+            {
+                wide /= 10;
+            }
+            value = wide > std::numeric_limits<double>::max() ? std::numeric_limits<double>::infinity() : (double)wide;
+        }
+        return negative ? -value : value;
+    }
+
+    /**
+        @brief Append _codepoint_ to _out_ as UTF-8.
+    */
+    static constexpr void appendUtf8(std::string& out, const uint32_t codepoint)
+    {
+        if (codepoint < 0x80)
+        {
+            out.push_back((char)codepoint);
+        }
+        else if (codepoint < 0x800)
+        {
+            out.push_back((char)(0xc0 | (codepoint >> 6)));
+            out.push_back((char)(0x80 | (codepoint & 0x3f)));
+        }
+        else if (codepoint < 0x10000)
+        {
+            out.push_back((char)(0xe0 | (codepoint >> 12)));
+            out.push_back((char)(0x80 | ((codepoint >> 6) & 0x3f)));
+            out.push_back((char)(0x80 | (codepoint & 0x3f)));
+        }
+        else
+        {
+            out.push_back((char)(0xf0 | (codepoint >> 18)));
+            out.push_back((char)(0x80 | ((codepoint >> 12) & 0x3f)));
+            out.push_back((char)(0x80 | ((codepoint >> 6) & 0x3f)));
+            out.push_back((char)(0x80 | (codepoint & 0x3f)));
+        }
+    }
+
+    /* Digit value of every hex character, -1 for the rest. */
+    static constexpr std::array<int8_t, 256> HEX_DIGITS = []()
+    {
+        std::array<int8_t, 256> table{};
+        table.fill(-1);
+        for (uint32_t i{0}; i < 10; i++)
+        {
+            table['0' + i] = (int8_t)i;
+        }
+        for (uint32_t i{0}; i < 6; i++)
+        {
+            table['a' + i] = (int8_t)(10 + i);
+            table['A' + i] = (int8_t)(10 + i);
+        }
+        return table;
+    }();
+
+    /* Decoded byte of every single character escape (\n, \" ...) indexed by the char after '\', 0 for the rest. */
+    static constexpr std::array<char, 256> SIMPLE_ESCAPES = []()
+    {
+        std::array<char, 256> table{};
+        table['"'] = '"';
+        table['\\'] = '\\';
+        table['/'] = '/';
+        table['b'] = '\b';
+        table['f'] = '\f';
+        table['n'] = '\n';
+        table['r'] = '\r';
+        table['t'] = '\t';
+        return table;
+    }();
+
+    /**
+        @brief Value of 4 hex digits at the start of _hex_, -1 if they aren't all hex digits.
+    */
+    static constexpr int32_t parseHex4(const std::string_view hex)
+    {
+        if (hex.size() < 4)
+        {
+            return -1;
+        }
+
+        const int32_t d0 = HEX_DIGITS[(uint8_t)hex[0]];
+        const int32_t d1 = HEX_DIGITS[(uint8_t)hex[1]];
+        const int32_t d2 = HEX_DIGITS[(uint8_t)hex[2]];
+        const int32_t d3 = HEX_DIGITS[(uint8_t)hex[3]];
+
+        /* Any -1 digit makes the OR negative. */
+        return (d0 | d1 | d2 | d3) < 0 ? -1 : (d0 << 12) | (d1 << 8) | (d2 << 4) | d3;
+    }
+
+    /**
+        @brief Decode one escape sequence at the start of _raw_ (which begins with '\') into _out_.
+        Surrogate pairs are joined, lone surrogates become U+FFFD. Returns the number of bytes consumed, 0 if invalid.
+    */
+    static constexpr uint64_t decodeEscape(const std::string_view raw, std::string& out)
+    {
+        if (raw.size() < 2)
+        {
+            return 0;
+        }
+
+        const char simple = SIMPLE_ESCAPES[(uint8_t)raw[1]];
+        if (simple != 0)
+        {
+            out.push_back(simple);
+            return 2;
+        }
+
+        if (raw[1] != 'u')
+        {
+            return 0;
+        }
+
+        const int32_t unit = parseHex4(raw.substr(2));
+        if (unit < 0)
+        {
+            return 0;
+        }
+
+        if (unit >= 0xd800 && unit <= 0xdbff && raw.size() >= 12 && raw[6] == '\\' && raw[7] == 'u')
+        {
+            const int32_t low = parseHex4(raw.substr(8));
+            if (low >= 0xdc00 && low <= 0xdfff)
+            {
+                appendUtf8(out, 0x10000 + ((unit - 0xd800) << 10) + (low - 0xdc00));
+                return 12;
+            }
+        }
+
+        appendUtf8(out, (unit >= 0xd800 && unit <= 0xdfff) ? 0xfffd : unit);
+        return 6;
+    }
+
+    /**
+        @brief Decode every escape in an already validated raw string.
+    */
+    static constexpr void decodeEscapes(const std::string_view raw, std::string& out)
+    {
+        uint64_t i{0};
+        while (i < raw.size())
+        {
+            const uint64_t escape = raw.find('\\', i);
+            if (escape == std::string_view::npos)
+            {
+                out.append(raw.substr(i));
+                return;
+            }
+
+            out.append(raw.substr(i, escape - i));
+            const uint64_t consumed = decodeEscape(raw.substr(escape), out);
+            i = escape + (consumed == 0 ? 1 : consumed);
+        }
+    }
+
+private:
+    static constexpr uint64_t findInvalidUtf8(const std::string_view str)
+    {
+        if consteval
+        {
+            uint64_t i{0};
+            simd::scanUtf8(str.data(), str.size(), i, str.size());
+            return i;
+        }
+        return simd::findInvalidUtf8(str.data(), str.size());
+    }
+
+    static constexpr bool isWhitespace(const char ch)
+    {
+        return ch == ' ' || ch == '\n' || ch == '\r' || ch == '\t';
+    }
+
+    constexpr bool skipDigits()
+    {
+        const uint64_t start = pos;
+        while (pos < data.size() && data[pos] >= '0' && data[pos] <= '9')
+        {
+            pos++;
+        }
+        return pos != start;
+    }
+
+    constexpr bool skipEscape()
+    {
+        /* pos is at the backslash */
+        if (pos + 1 >= data.size())
+        {
+            return fail("Unterminated escape sequence");
+        }
+
+        const char kind = data[pos + 1];
+        if (kind == 'u')
+        {
+            if (parseHex4(data.substr(pos + 2)) < 0)
+            {
+                return fail("Invalid \\u escape, expected 4 hex digits");
+            }
+            pos += 6;
+            return true;
+        }
+
+        if (SIMPLE_ESCAPES[(uint8_t)kind] == 0)
+        {
+            return fail("Invalid escape sequence");
+        }
+        pos += 2;
+        return true;
+    }
+
+    constexpr bool enterContainer(const char open, const char close, const char* message, bool& hasItems)
+    {
+        if (!expect(open, message))
+        {
+            return false;
+        }
+
+        hasItems = peekToken() != close;
+        if (!hasItems)
+        {
+            pos++;
+        }
+        return true;
+    }
+
+    constexpr bool nextInContainer(const char close, const char* message, bool& hasMore)
+    {
+        const char ch = peekToken();
+        if (ch == ',')
+        {
+            pos++;
+            hasMore = true;
+            return true;
+        }
+        else if (ch == close)
+        {
+            pos++;
+            hasMore = false;
+            return true;
+        }
+        hasMore = false;
+        return fail(message);
+    }
+
+    std::string_view data;
+    uint64_t pos{0};
+    const char* error{nullptr};
+    uint64_t errorOffset{0};
+    bool utf8Validation{true};
+};
+
+} // namespace hk
@@ -0,0 +1,212 @@
+#include "JsonReclaimer.hpp"
+
+#include <algorithm>
+
+namespace hk
+{
+
+namespace
+{
+/* Extract every entry of _object_: the value goes into _children_, the emptied node (key included) into
+   _entries_ and the empty map itself into _shells_. */
+void openObject(Json::JsonObjectNode& object, std::vector<Json::JsonFieldValue>& children,
+    std::vector<Json::JsonObjectNode::node_type>& entries, std::vector<Json::JsonFieldValue>& shells)
+{
+    while (!object.empty())
+    {
+        entries.push_back(object.extract(object.begin()));
+        children.push_back(std::move(entries.back().mapped()));
+    }
+    Json::JsonFieldValue shell;
+    shell = std::move(object);
+    shells.push_back(std::move(shell));
+}
+
+/* Move the elements of _list_ into _children_, the list left holding moved from elements into _shells_. */
+void openList(Json::JsonListNode& list, std::vector<Json::JsonFieldValue>& children,
+    std::vector<Json::JsonFieldValue>& shells)
+{
+    for (Json::JsonFieldValue& child : list)
+    {
+        children.push_back(std::move(child));
+    }
+    Json::JsonFieldValue shell;
+    shell = std::move(list);
+    shells.push_back(std::move(shell));
+}
+
+/* Open _value_ with openObject/openList. False if it isn't a container. */
+bool takeChildren(Json::JsonFieldValue& value, std::vector<Json::JsonFieldValue>& children,
+    std::vector<Json::JsonObjectNode::node_type>& entries, std::vector<Json::JsonFieldValue>& shells)
+{
+    if (value.isObject())
+    {
+        openObject(value.getObject(), children, entries, shells);
+        return true;
+    }
+    if (value.isList())
+    {
+        openList(value.getList(), children, shells);
+        return true;
+    }
+    return false;
+}
+} // namespace
+
+JsonReclaimer::JsonReclaimer(const uint32_t threads)
+{
+    for (uint32_t i{0}; i < std::max<uint32_t>(threads, 1); i++)
+    {
+        workers.emplace_back(&JsonReclaimer::work, this);
+    }
+}
+
+JsonReclaimer::~JsonReclaimer()
+{
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        stopping = true;
+    }
+    wake.notify_all();
+    for (std::thread& worker : workers)
+    {
+        worker.join();
+    }
+}
+
+void JsonReclaimer::retire(Json::JsonRootNode&& root)
+{
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        roots.push_back(std::move(root));
+    }
+    wake.notify_one();
+}
+
+std::shared_ptr<Json::JsonRootNode> JsonReclaimer::adopt(Json::JsonRootNode&& root)
+{
+    return std::shared_ptr<Json::JsonRootNode>{new Json::JsonRootNode{std::move(root)},
+        [this](Json::JsonRootNode* node)
+        {
+            retire(std::move(*node));
+            delete node;
+        }};
+}
+
+void JsonReclaimer::drain()
+{
+    std::unique_lock<std::mutex> lock{mutex};
+    idle.wait(lock, [this]() { return roots.empty() && pieces.empty() && busy == 0; });
+}
+
+void JsonReclaimer::work()
+{
+    std::unique_lock<std::mutex> lock{mutex};
+    while (true)
+    {
+        wake.wait(lock, [this]() { return stopping || !roots.empty() || !pieces.empty(); });
+
+        /* Pieces first: they are the parallel part, roots only get split. */
+        if (!pieces.empty())
+        {
+            Pieces doomed = std::move(pieces.front());
+            pieces.pop_front();
+            busy++;
+            lock.unlock();
+            doomed = Pieces{};
+            lock.lock();
+            busy--;
+        }
+        else if (!roots.empty())
+        {
+            Json::JsonRootNode root = std::move(roots.front());
+            roots.pop_front();
+            busy++;
+            lock.unlock();
+            scatter(root);
+            root = Json::JsonRootNode{Json::JsonObjectNode{}};
+            lock.lock();
+            busy--;
+        }
+        else if (stopping)
+        {
+            return;
+        }
+
+        if (roots.empty() && pieces.empty() && busy == 0)
+        {
+            idle.notify_all();
+        }
+    }
+}
+
+void JsonReclaimer::scatter(Json::JsonRootNode& root)
+{
+    /* What's left of the opened containers (object entries with their keys, emptied lists and maps) is spread
+       over the batches too, so not even the shell of a big container is freed on this thread. */
+    Pieces spent;
+    std::vector<Json::JsonFieldValue> all;
+    if (root.isObject())
+    {
+        openObject(root.getObject(), all, spent.entries, spent.values);
+    }
+    else
+    {
+        openList(root.getList(), all, spent.values);
+    }
+
+    /* Too few siblings to keep every worker busy ({"data": [...]}): open the containers among them, level by
+       level. */
+    const uint64_t wanted = workers.size() * PIECES_PER_WORKER;
+    while (all.size() < wanted)
+    {
+        std::vector<Json::JsonFieldValue> next;
+        bool opened{false};
+        for (Json::JsonFieldValue& piece : all)
+        {
+            if (takeChildren(piece, next, spent.entries, spent.values))
+            {
+                opened = true;
+            }
+            else
+            {
+                next.push_back(std::move(piece));
+            }
+        }
+        all = std::move(next);
+        if (!opened)
+        {
+            break;
+        }
+    }
+
+    const uint64_t chunks = std::min<uint64_t>(wanted, all.size() + spent.values.size() + spent.entries.size());
+    if (chunks == 0)
+    {
+        return;
+    }
+
+    std::vector<Pieces> batches(chunks);
+    for (uint64_t i{0}; i < all.size(); i++)
+    {
+        batches[i * chunks / all.size()].values.push_back(std::move(all[i]));
+    }
+    for (uint64_t i{0}; i < spent.values.size(); i++)
+    {
+        batches[i % chunks].values.push_back(std::move(spent.values[i]));
+    }
+    for (uint64_t i{0}; i < spent.entries.size(); i++)
+    {
+        batches[i % chunks].entries.push_back(std::move(spent.entries[i]));
+    }
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        for (Pieces& batch : batches)
+        {
+            pieces.push_back(std::move(batch));
+        }
+    }
+    wake.notify_all();
+}
+
+} // namespace hk
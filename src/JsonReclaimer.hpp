@@ -0,0 +1,79 @@
+#pragma once
+
+#include "HkJson.hpp"
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace hk
+{
+
+/* Frees documents on background threads, so dropping a huge document doesn't stall the thread that drops it.
+    - retire() only moves the root into a queue, O(1) for the caller.
+    - A worker breaks the retired document into sibling subtrees, opening up nested containers until there are
+      enough pieces for every worker. The pieces are freed in parallel, and so are the opened containers: object
+      entries are extracted one by one, so a single huge object doesn't leave its nodes and keys to one thread.
+    - adopt() wraps a document into a shared pointer that retires it here once its last owner lets go, which fits
+      documents replaced under readers (JsonWatchedFile, caches). The reclaimer must outlive those pointers.
+    - The destructor frees everything still queued before returning.
+
+    JsonReclaimer reclaimer;
+    reclaimer.retire(std::move(*oldConfig));
+*/
+class JsonReclaimer
+{
+public:
+    static constexpr uint32_t DEFAULT_THREADS{4};
+
+    explicit JsonReclaimer(const uint32_t threads = DEFAULT_THREADS);
+    JsonReclaimer(const JsonReclaimer&) = delete;
+    JsonReclaimer& operator=(const JsonReclaimer&) = delete;
+    ~JsonReclaimer();
+
+    /**
+        @brief Hand _root_ over to be freed in the background.
+    */
+    void retire(Json::JsonRootNode&& root);
+
+    /**
+        @brief Shared document whose teardown is retired here when the last reference goes away.
+    */
+    std::shared_ptr<Json::JsonRootNode> adopt(Json::JsonRootNode&& root);
+
+    /**
+        @brief Block until everything retired so far has been freed.
+    */
+    void drain();
+
+private:
+    /* One batch of a retired document: subtrees, emptied containers, and entries extracted from opened objects
+       (node and key, the value already moved out). */
+    struct Pieces
+    {
+        std::vector<Json::JsonFieldValue> values;
+        std::vector<Json::JsonObjectNode::node_type> entries;
+    };
+
+    /* Pieces per worker, more than one so a worker stuck on a big subtree doesn't hold the others back. */
+    static constexpr uint64_t PIECES_PER_WORKER{4};
+
+    void work();
+    void scatter(Json::JsonRootNode& root);
+
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable idle;
+    std::deque<Json::JsonRootNode> roots;
+    std::deque<Pieces> pieces;
+    uint64_t busy{0};
+    bool stopping{false};
+
+    std::vector<std::thread> workers;
+};
+
+} // namespace hk
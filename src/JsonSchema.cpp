@@ -0,0 +1,828 @@
+#include "JsonSchema.hpp"
+
+#include "JsonBinding.hpp"
+#include "JsonPatch.hpp"
+#include "Utility.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace hk
+{
+
+namespace
+{
+constexpr std::pair<std::string_view, uint8_t> TYPE_NAMES[] = {{"null", 1 << 0}, {"boolean", 1 << 1},
+    {"integer", 1 << 2}, {"number", (1 << 2) | (1 << 3)}, {"string", 1 << 4}, {"object", 1 << 5}, {"array", 1 << 6}};
+
+std::string describeTypes(const uint8_t mask)
+{
+    std::string result;
+    for (const auto& [name, bits] : TYPE_NAMES)
+    {
+        /* "number" covers integers too, don't list integer separately then. */
+        if ((mask & bits) == bits && !(name == "integer" && (mask & (1 << 3))))
+        {
+            result += result.empty() ? "" : "|";
+            result += name;
+        }
+    }
+    return result;
+}
+
+std::string describeTypeMismatch(const uint8_t allowed, const uint8_t actual)
+{
+    /* An integral value carries both number bits, name the narrower one. */
+    const char* actualName = (actual & (1 << 2)) ? "integer" : (actual & (1 << 3)) ? "number" : nullptr;
+
+    std::string reason;
+    sprint(reason, "expected %s, got %s", describeTypes(allowed).c_str(),
+        actualName ? actualName : describeTypes(actual).c_str());
+    return reason;
+}
+
+bool readNumber(const Json::JsonFieldValue& value, double& out)
+{
+    if (value.isInt())
+    {
+        out = (double)value.getInt();
+        return true;
+    }
+    if (value.isDouble())
+    {
+        out = value.getDouble();
+        return true;
+    }
+    return false;
+}
+
+uint64_t countCodepoints(const std::string_view str)
+{
+    uint64_t count{0};
+    for (const char ch : str)
+    {
+        count += ((uint8_t)ch & 0xc0) != 0x80;
+    }
+    return count;
+}
+} // namespace
+
+struct JsonSchema::Compiler
+{
+    JsonSchema& schema;
+    std::string error;
+
+    int32_t compileNode(const Json::JsonFieldValue& value, std::string& path)
+    {
+        if (value.isBool())
+        {
+            schema.nodes.emplace_back().rejectAll = !value.getBool();
+            return schema.nodes.size() - 1;
+        }
+        if (!value.isObject())
+        {
+            return fail(path, "schema must be an object or a boolean");
+        }
+
+        const int32_t index = schema.nodes.size();
+        schema.nodes.emplace_back();
+
+        /* Children get compiled while walking the keywords, so this node's own table entries are collected
+           on the side and appended in one go to stay contiguous. */
+        Node node;
+        std::vector<Check> checks;
+        std::vector<Property> nodeProperties;
+        std::vector<std::string> nodeRequired;
+
+        for (const auto& [keyword, arg] : value.getObject())
+        {
+            const uint64_t pathSize = path.size();
+            JsonPatch::appendPointerToken(path, keyword);
+
+            bool ok{true};
+            if (keyword == "type")
+            {
+                ok = compileType(arg, node, path);
+            }
+            else if (keyword == "enum" || keyword == "const")
+            {
+                ok = keyword == "const" || arg.isList();
+                if (ok)
+                {
+                    const uint32_t first = schema.constants.size();
+                    if (arg.isList())
+                    {
+                        schema.constants.insert(schema.constants.end(), arg.getList().begin(), arg.getList().end());
+                    }
+                    else
+                    {
+                        schema.constants.push_back(arg);
+                    }
+                    checks.push_back(Check{.op = Op::ENUM,
+                        .operand = first,
+                        .count = (uint32_t)(schema.constants.size() - first)});
+                    node.hasEnum = true;
+                }
+                else
+                {
+                    fail(path, "enum must be an array");
+                }
+            }
+            else if (keyword == "minimum" || keyword == "maximum" || keyword == "exclusiveMinimum" ||
+                     keyword == "exclusiveMaximum")
+            {
+                double limit{0};
+                ok = readNumber(arg, limit);
+                const Op op = keyword == "minimum"            ? Op::MINIMUM
+                              : keyword == "maximum"          ? Op::MAXIMUM
+                              : keyword == "exclusiveMinimum" ? Op::EXCLUSIVE_MINIMUM
+                                                              : Op::EXCLUSIVE_MAXIMUM;
+                ok ? checks.push_back(Check{.op = op, .number = limit}) : (void)fail(path, "must be a number");
+            }
+            else if (keyword == "minLength" || keyword == "maxLength" || keyword == "minItems" ||
+                     keyword == "maxItems" || keyword == "minProperties" || keyword == "maxProperties")
+            {
+                ok = arg.isInt() && arg.getInt() >= 0;
+                const Op op = keyword == "minLength"       ? Op::MIN_LENGTH
+                              : keyword == "maxLength"     ? Op::MAX_LENGTH
+                              : keyword == "minItems"      ? Op::MIN_ITEMS
+                              : keyword == "maxItems"      ? Op::MAX_ITEMS
+                              : keyword == "minProperties" ? Op::MIN_PROPERTIES
+                                                           : Op::MAX_PROPERTIES;
+                node.hasStringChecks |= op == Op::MIN_LENGTH || op == Op::MAX_LENGTH;
+                ok ? checks.push_back(Check{.op = op, .number = (double)arg.getInt()})
+                   : (void)fail(path, "must be a non negative integer");
+            }
+            else if (keyword == "pattern")
+            {
+                ok = compilePattern(arg, path);
+                if (ok)
+                {
+                    checks.push_back(Check{.op = Op::PATTERN, .operand = (uint32_t)(schema.patterns.size() - 1)});
+                    node.hasStringChecks = true;
+                }
+            }
+            else if (keyword == "items")
+            {
+                node.items = arg.isList() ? fail(path, "array form of items is not supported") : compileNode(arg, path);
+                ok = node.items >= 0;
+            }
+            else if (keyword == "additionalProperties" && arg.isBool())
+            {
+                node.additional = arg.getBool() ? ANY_ALLOWED : FORBIDDEN;
+            }
+            else if (keyword == "additionalProperties")
+            {
+                node.additional = compileNode(arg, path);
+                ok = node.additional >= 0;
+            }
+            else if (keyword == "properties" && !arg.isObject())
+            {
+                ok = false;
+                fail(path, "properties must be an object");
+            }
+            else if (keyword == "properties")
+            {
+                for (const auto& [name, subschema] : arg.getObject())
+                {
+                    const uint64_t propSize = path.size();
+                    JsonPatch::appendPointerToken(path, name);
+                    const int32_t child = compileNode(subschema, path);
+                    path.resize(propSize);
+                    if (child < 0)
+                    {
+                        ok = false;
+                        break;
+                    }
+                    nodeProperties.push_back(Property{.key = name, .node = (uint32_t)child});
+                }
+            }
+            else if (keyword == "required")
+            {
+                ok = arg.isList() && std::all_of(arg.getList().begin(), arg.getList().end(),
+                                         [](const Json::JsonFieldValue& item) { return item.isString(); });
+                if (ok)
+                {
+                    for (const Json::JsonFieldValue& item : arg.getList())
+                    {
+                        nodeRequired.push_back(item.getString());
+                    }
+                }
+                else
+                {
+                    fail(path, "required must be an array of strings");
+                }
+            }
+
+            path.resize(pathSize);
+            if (!ok)
+            {
+                return -1;
+            }
+        }
+
+        std::sort(nodeProperties.begin(), nodeProperties.end(),
+            [](const Property& lhs, const Property& rhs) { return lhs.key < rhs.key; });
+
+        node.checksBegin = schema.program.size();
+        schema.program.insert(schema.program.end(), checks.begin(), checks.end());
+        node.checksEnd = schema.program.size();
+
+        node.propertiesBegin = schema.properties.size();
+        std::move(nodeProperties.begin(), nodeProperties.end(), std::back_inserter(schema.properties));
+        node.propertiesEnd = schema.properties.size();
+
+        node.requiredBegin = schema.requiredKeys.size();
+        std::move(nodeRequired.begin(), nodeRequired.end(), std::back_inserter(schema.requiredKeys));
+        node.requiredEnd = schema.requiredKeys.size();
+
+        schema.nodes[index] = node;
+        return index;
+    }
+
+    bool compileType(const Json::JsonFieldValue& arg, Node& node, const std::string& path)
+    {
+        Json::JsonListNode names = arg.isList() ? arg.getList() : Json::JsonListNode{arg};
+        node.types = 0;
+        for (const Json::JsonFieldValue& name : names)
+        {
+            const auto it = std::find_if(std::begin(TYPE_NAMES), std::end(TYPE_NAMES),
+                [&name](const auto& entry) { return name.isString() && entry.first == name.getString(); });
+            if (it == std::end(TYPE_NAMES))
+            {
+                fail(path, "unknown type name");
+                return false;
+            }
+            node.types |= it->second;
+        }
+        return true;
+    }
+
+    bool compilePattern(const Json::JsonFieldValue& arg, const std::string& path)
+    {
+        if (!arg.isString())
+        {
+            fail(path, "pattern must be a string");
+            return false;
+        }
+
+        /* std::regex only reports bad patterns by throwing, keep that from leaking out of compile(). */
+        try
+        {
+            schema.patterns.emplace_back(arg.getString(), std::regex::ECMAScript | std::regex::optimize);
+        }
+        catch (const std::regex_error& e)
+        {
+            fail(path, e.what());
+            return false;
+        }
+        return true;
+    }
+
+    int32_t fail(const std::string& path, const char* reason)
+    {
+        if (error.empty())
+        {
+            sprint(error, "Invalid schema at '%s': %s", path.c_str(), reason);
+        }
+        return -1;
+    }
+};
+
+struct JsonSchema::TextValidator
+{
+    const JsonSchema& schema;
+    JsonReader reader;
+    std::string path;
+    std::string error;
+    std::string scratch;
+
+    bool validateValue(const uint32_t nodeIndex, const uint32_t depth)
+    {
+        if (depth > JsonReader::MAX_DEPTH)
+        {
+            return reader.fail("Document nested too deep");
+        }
+
+        const Node& node = schema.nodes[nodeIndex];
+        if (node.rejectAll)
+        {
+            return fail("no value is allowed here");
+        }
+
+        /* enum/const compare whole values, cheaper to materialize just this one than to stream compare. */
+        if (node.hasEnum)
+        {
+            Json::JsonFieldValue value;
+            if (!JsonBind::readValue(reader, value, depth))
+            {
+                return false;
+            }
+            std::string result = schema.validateValue(nodeIndex, value, path);
+            return result.empty() || report(std::move(result));
+        }
+
+        switch (reader.peekToken())
+        {
+            case '{':
+                return checkType(node, TYPE_OBJECT) && validateObject(node, depth);
+            case '[':
+                return checkType(node, TYPE_ARRAY) && validateList(node, depth);
+            case '"': {
+                if (!checkType(node, TYPE_STRING))
+                {
+                    return false;
+                }
+                if (!node.hasStringChecks)
+                {
+                    std::string_view raw;
+                    bool hasEscapes{false};
+                    return reader.readRawString(raw, hasEscapes);
+                }
+
+                scratch.clear();
+                if (!reader.readString(scratch))
+                {
+                    return false;
+                }
+                const Check* failed = schema.runStringChecks(node, scratch);
+                return failed == nullptr || fail(schema.describeCheck(*failed).c_str());
+            }
+            case 't':
+                return checkType(node, TYPE_BOOL) && reader.readLiteral("true");
+            case 'f':
+                return checkType(node, TYPE_BOOL) && reader.readLiteral("false");
+            case 'n':
+                return checkType(node, TYPE_NULL) && reader.readLiteral("null");
+            default: {
+                std::string_view raw;
+                bool isInteger{false};
+                if (!reader.readNumber(raw, isInteger))
+                {
+                    return false;
+                }
+
+                const double number = JsonReader::toDouble(raw);
+                const uint8_t types = TYPE_NUMBER | ((isInteger || std::trunc(number) == number) ? TYPE_INTEGER : 0);
+                if (!checkType(node, types))
+                {
+                    return false;
+                }
+                const Check* failed = schema.runNumberChecks(node, number);
+                return failed == nullptr || fail(schema.describeCheck(*failed).c_str());
+            }
+        }
+    }
+
+    bool validateObject(const Node& node, const uint32_t depth)
+    {
+        const uint32_t requiredCount = node.requiredEnd - node.requiredBegin;
+        std::vector<bool> seen(requiredCount);
+        std::string decodedKey;
+        uint64_t memberCount{0};
+
+        bool hasMembers{false};
+        reader.enterObject(hasMembers);
+        while (hasMembers)
+        {
+            std::string_view key;
+            bool hasEscapes{false};
+            if (!reader.readKey(key, hasEscapes))
+            {
+                return false;
+            }
+            if (hasEscapes)
+            {
+                decodedKey.clear();
+                JsonReader::decodeEscapes(key, decodedKey);
+                key = decodedKey;
+            }
+
+            for (uint32_t i{0}; i < requiredCount; i++)
+            {
+                seen[i] = seen[i] || schema.requiredKeys[node.requiredBegin + i] == key;
+            }
+
+            const uint64_t pathSize = path.size();
+            JsonPatch::appendPointerToken(path, key);
+
+            const int32_t property = schema.findProperty(node, key);
+            const int32_t child = property >= 0 ? property : node.additional;
+            bool valid{true};
+            if (child == FORBIDDEN)
+            {
+                valid = fail("property is not allowed");
+            }
+            else if (child == ANY_ALLOWED)
+            {
+                valid = reader.skipValue(depth + 1);
+            }
+            else
+            {
+                valid = validateValue(child, depth + 1);
+            }
+
+            path.resize(pathSize);
+            if (!valid || !reader.nextMember(hasMembers))
+            {
+                return false;
+            }
+            memberCount++;
+        }
+
+        for (uint32_t i{0}; i < requiredCount; i++)
+        {
+            if (!seen[i])
+            {
+                std::string reason;
+                sprint(reason, "missing required property '%s'", schema.requiredKeys[node.requiredBegin + i].c_str());
+                return fail(reason.c_str());
+            }
+        }
+
+        const Check* failed = schema.runCountChecks(node, Op::MIN_PROPERTIES, Op::MAX_PROPERTIES, memberCount);
+        return reader.ok() && (failed == nullptr || fail(schema.describeCheck(*failed).c_str()));
+    }
+
+    bool validateList(const Node& node, const uint32_t depth)
+    {
+        uint64_t itemCount{0};
+        bool hasElements{false};
+        reader.enterArray(hasElements);
+        while (hasElements)
+        {
+            const uint64_t pathSize = path.size();
+            path += '/';
+            path += std::to_string(itemCount);
+
+            const bool valid =
+                node.items == ANY_ALLOWED ? reader.skipValue(depth + 1) : validateValue(node.items, depth + 1);
+            path.resize(pathSize);
+            if (!valid || !reader.nextElement(hasElements))
+            {
+                return false;
+            }
+            itemCount++;
+        }
+
+        const Check* failed = schema.runCountChecks(node, Op::MIN_ITEMS, Op::MAX_ITEMS, itemCount);
+        return reader.ok() && (failed == nullptr || fail(schema.describeCheck(*failed).c_str()));
+    }
+
+    bool checkType(const Node& node, const uint8_t types)
+    {
+        if (node.types & types)
+        {
+            return true;
+        }
+
+        return fail(describeTypeMismatch(node.types, types).c_str());
+    }
+
+    bool fail(const char* reason)
+    {
+        return report(violation(path, reason));
+    }
+
+    bool report(std::string message)
+    {
+        if (error.empty())
+        {
+            error = std::move(message);
+            reader.fail("Schema violation");
+        }
+        return false;
+    }
+};
+
+JsonSchema::CompileResult JsonSchema::compile(const Json::JsonRootNode& schemaDoc)
+{
+    std::shared_ptr<JsonSchema> schema{new JsonSchema{}};
+    Compiler compiler{.schema = *schema, .error = ""};
+
+    std::string path;
+    const Json::JsonFieldValue rootValue = std::holds_alternative<Json::JsonObjectNode>(schemaDoc)
+                                               ? Json::JsonFieldValue{std::get<Json::JsonObjectNode>(schemaDoc)}
+                                               : Json::JsonFieldValue{std::get<Json::JsonListNode>(schemaDoc)};
+    if (compiler.compileNode(rootValue, path) < 0)
+    {
+        return {.schema = nullptr, .error = compiler.error};
+    }
+    return {.schema = std::move(schema), .error = ""};
+}
+
+std::string JsonSchema::validate(const Json::JsonRootNode& doc) const
+{
+    /* validateValue's checks, run on the root in place: wrapping it into a JsonFieldValue would copy the document. */
+    std::string path;
+    const Node& node = nodes[0];
+    if (node.rejectAll)
+    {
+        return violation(path, "no value is allowed here");
+    }
+
+    const bool isObject = std::holds_alternative<Json::JsonObjectNode>(doc);
+    const uint8_t type = isObject ? TYPE_OBJECT : TYPE_ARRAY;
+    if (!(node.types & type))
+    {
+        return violation(path, describeTypeMismatch(node.types, type).c_str());
+    }
+
+    if (node.hasEnum && !matchesEnum(node, doc))
+    {
+        return violation(path, "value is not one of the allowed values");
+    }
+
+    return isObject ? validateObject(0, std::get<Json::JsonObjectNode>(doc), path)
+                    : validateList(0, std::get<Json::JsonListNode>(doc), path);
+}
+
+std::string JsonSchema::validate(const Json::JsonFieldValue& value) const
+{
+    std::string path;
+    return validateValue(0, value, path);
+}
+
+std::string JsonSchema::validate(const std::string_view text) const
+{
+    TextValidator validator{.schema = *this, .reader = JsonReader{text}, .path = "", .error = "", .scratch = ""};
+    if (validator.validateValue(0, 0) && !validator.reader.isAtEnd())
+    {
+        validator.reader.fail("Unexpected data after the document end");
+    }
+
+    if (!validator.error.empty())
+    {
+        std::string result;
+        sprint(result, "%s at offset %lu", validator.error.c_str(), validator.reader.getErrorOffset());
+        return result;
+    }
+    return validator.reader.describeError();
+}
+
+std::string JsonSchema::validateValue(const uint32_t nodeIndex, const Json::JsonFieldValue& value,
+    std::string& path) const
+{
+    const Node& node = nodes[nodeIndex];
+    if (node.rejectAll)
+    {
+        return violation(path, "no value is allowed here");
+    }
+
+    const uint8_t types = typeOf(value);
+    if (!(node.types & types))
+    {
+        return violation(path, describeTypeMismatch(node.types, types).c_str());
+    }
+
+    if (node.hasEnum && !matchesEnum(node, value))
+    {
+        return violation(path, "value is not one of the allowed values");
+    }
+
+    const Check* failed{nullptr};
+    double number{0};
+    if (readNumber(value, number))
+    {
+        failed = runNumberChecks(node, number);
+    }
+    else if (value.isString())
+    {
+        failed = runStringChecks(node, value.getString());
+    }
+    else if (value.isObject())
+    {
+        return validateObject(nodeIndex, value.getObject(), path);
+    }
+    else if (value.isList())
+    {
+        return validateList(nodeIndex, value.getList(), path);
+    }
+    return failed == nullptr ? "" : violation(path, describeCheck(*failed).c_str());
+}
+
+std::string JsonSchema::validateObject(const uint32_t nodeIndex, const Json::JsonObjectNode& objNode,
+    std::string& path) const
+{
+    const Node& node = nodes[nodeIndex];
+    for (uint32_t i = node.requiredBegin; i < node.requiredEnd; i++)
+    {
+        if (!objNode.contains(requiredKeys[i]))
+        {
+            std::string reason;
+            sprint(reason, "missing required property '%s'", requiredKeys[i].c_str());
+            return violation(path, reason.c_str());
+        }
+    }
+
+    const Check* failed = runCountChecks(node, Op::MIN_PROPERTIES, Op::MAX_PROPERTIES, objNode.size());
+    if (failed != nullptr)
+    {
+        return violation(path, describeCheck(*failed).c_str());
+    }
+
+    for (const auto& [key, value] : objNode)
+    {
+        const int32_t property = findProperty(node, key);
+        const int32_t child = property >= 0 ? property : node.additional;
+        if (child == ANY_ALLOWED)
+        {
+            continue;
+        }
+
+        const uint64_t pathSize = path.size();
+        JsonPatch::appendPointerToken(path, key);
+        std::string result = child == FORBIDDEN ? violation(path, "property is not allowed")
+                                                : validateValue(child, value, path);
+        path.resize(pathSize);
+        if (!result.empty())
+        {
+            return result;
+        }
+    }
+    return "";
+}
+
+std::string JsonSchema::validateList(const uint32_t nodeIndex, const Json::JsonListNode& listNode,
+    std::string& path) const
+{
+    const Node& node = nodes[nodeIndex];
+    const Check* failed = runCountChecks(node, Op::MIN_ITEMS, Op::MAX_ITEMS, listNode.size());
+    if (failed != nullptr)
+    {
+        return violation(path, describeCheck(*failed).c_str());
+    }
+    if (node.items == ANY_ALLOWED)
+    {
+        return "";
+    }
+
+    for (uint64_t i{0}; i < listNode.size(); i++)
+    {
+        const uint64_t pathSize = path.size();
+        path += '/';
+        path += std::to_string(i);
+        std::string result = validateValue(node.items, listNode[i], path);
+        path.resize(pathSize);
+        if (!result.empty())
+        {
+            return result;
+        }
+    }
+    return "";
+}
+
+const JsonSchema::Check* JsonSchema::runNumberChecks(const Node& node, const double number) const
+{
+    for (uint32_t i = node.checksBegin; i < node.checksEnd; i++)
+    {
+        const Check& check = program[i];
+        const bool failed = (check.op == Op::MINIMUM && number < check.number) ||
+                            (check.op == Op::MAXIMUM && number > check.number) ||
+                            (check.op == Op::EXCLUSIVE_MINIMUM && number <= check.number) ||
+                            (check.op == Op::EXCLUSIVE_MAXIMUM && number >= check.number);
+        if (failed)
+        {
+            return &check;
+        }
+    }
+    return nullptr;
+}
+
+const JsonSchema::Check* JsonSchema::runStringChecks(const Node& node, const std::string_view str) const
+{
+    for (uint32_t i = node.checksBegin; i < node.checksEnd; i++)
+    {
+        const Check& check = program[i];
+        if (check.op == Op::MIN_LENGTH || check.op == Op::MAX_LENGTH)
+        {
+            const uint64_t length = countCodepoints(str);
+            if ((check.op == Op::MIN_LENGTH && length < check.number) ||
+                (check.op == Op::MAX_LENGTH && length > check.number))
+            {
+                return &check;
+            }
+        }
+        else if (check.op == Op::PATTERN && !std::regex_search(str.begin(), str.end(), patterns[check.operand]))
+        {
+            return &check;
+        }
+    }
+    return nullptr;
+}
+
+const JsonSchema::Check* JsonSchema::runCountChecks(const Node& node, const Op minOp, const Op maxOp,
+    const uint64_t count) const
+{
+    for (uint32_t i = node.checksBegin; i < node.checksEnd; i++)
+    {
+        const Check& check = program[i];
+        if ((check.op == minOp && count < check.number) || (check.op == maxOp && count > check.number))
+        {
+            return &check;
+        }
+    }
+    return nullptr;
+}
+
+template <typename Value>
+bool JsonSchema::matchesEnum(const Node& node, const Value& value) const
+{
+    for (uint32_t i = node.checksBegin; i < node.checksEnd; i++)
+    {
+        const Check& check = program[i];
+        if (check.op != Op::ENUM)
+        {
+            continue;
+        }
+
+        const auto first = constants.begin() + check.operand;
+        const bool matched = std::any_of(first, first + check.count,
+            [&value](const Json::JsonFieldValue& allowed) { return Json::valuesEqual(allowed, value); });
+        if (!matched)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+int32_t JsonSchema::findProperty(const Node& node, const std::string_view key) const
+{
+    const auto first = properties.begin() + node.propertiesBegin;
+    const auto last = properties.begin() + node.propertiesEnd;
+    const auto it = std::lower_bound(
+        first, last, key, [](const Property& property, const std::string_view name) { return property.key < name; });
+    return (it != last && it->key == key) ? (int32_t)it->node : -1;
+}
+
+std::string JsonSchema::describeCheck(const Check& check) const
+{
+    std::string reason;
+    switch (check.op)
+    {
+        case Op::MINIMUM:
+            sprint(reason, "value is less than minimum %g", check.number);
+            break;
+        case Op::MAXIMUM:
+            sprint(reason, "value is greater than maximum %g", check.number);
+            break;
+        case Op::EXCLUSIVE_MINIMUM:
+            sprint(reason, "value must be greater than %g", check.number);
+            break;
+        case Op::EXCLUSIVE_MAXIMUM:
+            sprint(reason, "value must be less than %g", check.number);
+            break;
+        case Op::MIN_LENGTH:
+            sprint(reason, "string is shorter than %g characters", check.number);
+            break;
+        case Op::MAX_LENGTH:
+            sprint(reason, "string is longer than %g characters", check.number);
+            break;
+        case Op::PATTERN:
+            reason = "string doesn't match the pattern";
+            break;
+        case Op::MIN_ITEMS:
+            sprint(reason, "array has fewer than %g items", check.number);
+            break;
+        case Op::MAX_ITEMS:
+            sprint(reason, "array has more than %g items", check.number);
+            break;
+        case Op::MIN_PROPERTIES:
+            sprint(reason, "object has fewer than %g properties", check.number);
+            break;
+        case Op::MAX_PROPERTIES:
+            sprint(reason, "object has more than %g properties", check.number);
+            break;
+        case Op::ENUM:
+            reason = "value is not one of the allowed values";
+            break;
+    }
+    return reason;
+}
+
+uint8_t JsonSchema::typeOf(const Json::JsonFieldValue& value)
+{
+    if (value.isInt())
+    {
+        return TYPE_INTEGER | TYPE_NUMBER;
+    }
+    if (value.isDouble())
+    {
+        const double number = value.getDouble();
+        return TYPE_NUMBER | (std::trunc(number) == number ? TYPE_INTEGER : 0);
+    }
+    return value.isNull()     ? TYPE_NULL
+           : value.isBool()   ? TYPE_BOOL
+           : value.isString() ? TYPE_STRING
+           : value.isObject() ? TYPE_OBJECT
+                              : TYPE_ARRAY;
+}
+
+std::string JsonSchema::violation(const std::string& path, const char* reason)
+{
+    std::string result;
+    sprint(result, "%s: %s", path.empty() ? "(root)" : path.c_str(), reason);
+    return result;
+}
+
+} // namespace hk
@@ -0,0 +1,151 @@
+#pragma once
+
+#include "HkJson.hpp"
+#include "JsonReader.hpp"
+
+#include <memory>
+#include <regex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace hk
+{
+
+/* JSON Schema validator compiled once into a flat program and run many times.
+    - Supported keywords: type, enum, const, minimum, maximum, exclusiveMinimum, exclusiveMaximum, minLength,
+      maxLength, pattern, items, minItems, maxItems, properties, required, additionalProperties,
+      minProperties, maxProperties. Boolean schemas work too. Other keywords ($schema, title...) are ignored.
+    - Every (sub)schema becomes a node; its scalar checks are a contiguous run of the flat check program,
+      object/array keywords are index ranges into shared tables. Nothing is looked up by name while validating.
+    - validate() runs over an already parsed document, or straight over the text without building a DOM,
+      stopping at the first violation. Errors start with the JSON pointer of the offending value ("(root)"
+      for the document itself).
+
+    auto [schema, error] = JsonSchema::compile(*json.loadFromFile("catalog.schema.json").json);
+    std::string violation = schema->validate(payloadText);
+*/
+class JsonSchema
+{
+public:
+    struct CompileResult
+    {
+        std::shared_ptr<const JsonSchema> schema;
+        const std::string error;
+    };
+
+    /**
+        @brief Compile a schema document. Malformed keywords are reported with the pointer to their schema.
+    */
+    static CompileResult compile(const Json::JsonRootNode& schemaDoc);
+
+    /**
+        @brief Validate a parsed document. Returns empty string if valid, "<pointer>: <reason>" otherwise.
+    */
+    std::string validate(const Json::JsonRootNode& doc) const;
+    std::string validate(const Json::JsonFieldValue& value) const;
+
+    /**
+        @brief Validate JSON text while tokenizing it, no DOM is built. Syntax errors and violations both end
+            the scan early and are reported with the byte offset.
+    */
+    std::string validate(const std::string_view text) const;
+
+private:
+    enum TypeBit : uint8_t
+    {
+        TYPE_NULL = 1 << 0,
+        TYPE_BOOL = 1 << 1,
+        TYPE_INTEGER = 1 << 2,
+        TYPE_NUMBER = 1 << 3,
+        TYPE_STRING = 1 << 4,
+        TYPE_OBJECT = 1 << 5,
+        TYPE_ARRAY = 1 << 6,
+        TYPE_ANY = 0x7f
+    };
+
+    enum class Op : uint8_t
+    {
+        MINIMUM,
+        MAXIMUM,
+        EXCLUSIVE_MINIMUM,
+        EXCLUSIVE_MAXIMUM,
+        MIN_LENGTH,
+        MAX_LENGTH,
+        PATTERN,
+        MIN_ITEMS,
+        MAX_ITEMS,
+        MIN_PROPERTIES,
+        MAX_PROPERTIES,
+        ENUM
+    };
+
+    struct Check
+    {
+        Op op;
+        double number{0};
+
+        /* Regex index for PATTERN, first constant for ENUM. */
+        uint32_t operand{0};
+        uint32_t count{0};
+    };
+
+    struct Property
+    {
+        std::string key;
+        uint32_t node{0};
+    };
+
+    static constexpr int32_t ANY_ALLOWED{-1};
+    static constexpr int32_t FORBIDDEN{-2};
+
+    struct Node
+    {
+        uint8_t types{TYPE_ANY};
+        bool rejectAll{false};
+        bool hasStringChecks{false};
+        bool hasEnum{false};
+        uint32_t checksBegin{0};
+        uint32_t checksEnd{0};
+
+        /* Sorted by key for binary search. */
+        uint32_t propertiesBegin{0};
+        uint32_t propertiesEnd{0};
+        uint32_t requiredBegin{0};
+        uint32_t requiredEnd{0};
+
+        /* Schema index, ANY_ALLOWED or FORBIDDEN. */
+        int32_t additional{ANY_ALLOWED};
+        int32_t items{ANY_ALLOWED};
+    };
+
+    struct Compiler;
+    struct TextValidator;
+
+    JsonSchema() = default;
+
+    std::string validateValue(const uint32_t node, const Json::JsonFieldValue& value, std::string& path) const;
+    std::string validateObject(const uint32_t node, const Json::JsonObjectNode& objNode, std::string& path) const;
+    std::string validateList(const uint32_t node, const Json::JsonListNode& listNode, std::string& path) const;
+
+    const Check* runNumberChecks(const Node& node, const double number) const;
+    const Check* runStringChecks(const Node& node, const std::string_view str) const;
+    const Check* runCountChecks(const Node& node, const Op minOp, const Op maxOp, const uint64_t count) const;
+    std::string describeCheck(const Check& check) const;
+    /* _value_ is a JsonFieldValue or a whole JsonRootNode, only used (and defined) in JsonSchema.cpp. */
+    template <typename Value>
+    bool matchesEnum(const Node& node, const Value& value) const;
+    int32_t findProperty(const Node& node, const std::string_view key) const;
+
+    static uint8_t typeOf(const Json::JsonFieldValue& value);
+    static std::string violation(const std::string& path, const char* reason);
+
+    std::vector<Node> nodes;
+    std::vector<Check> program;
+    std::vector<Property> properties;
+    std::vector<std::string> requiredKeys;
+    std::vector<Json::JsonFieldValue> constants;
+    std::vector<std::regex> patterns;
+};
+
+} // namespace hk
@@ -0,0 +1,253 @@
+#include "JsonSerializer.hpp"
+
+#include "SimdScan.hpp"
+#include <array>
+#include <charconv>
+#include <cmath>
+#include <cstring>
+
+namespace hk
+{
+
+namespace
+{
+/* "00" "01" ... "99" so integers are emitted two digits per division instead of one. */
+constexpr std::array<char, 200> DIGIT_PAIRS = []()
+{
+    std::array<char, 200> pairs{};
+    for (uint32_t i{0}; i < 100; i++)
+    {
+        pairs[i * 2] = '0' + i / 10;
+        pairs[i * 2 + 1] = '0' + i % 10;
+    }
+    return pairs;
+}();
+
+const char HEX_DIGITS[] = "0123456789abcdef";
+
+/* Short escapes for the control chars that have one, the rest go out as \u00XX. */
+constexpr std::array<char, 32> SHORT_ESCAPES = []()
+{
+    std::array<char, 32> table{};
+    table['\b'] = 'b';
+    table['\f'] = 'f';
+    table['\n'] = 'n';
+    table['\r'] = 'r';
+    table['\t'] = 't';
+    return table;
+}();
+} // namespace
+
+JsonSerializer::JsonSerializer(OutputBuffer& outBuffer)
+    : out{outBuffer}
+{}
+
+void JsonSerializer::write(const Json::JsonRootNode& node)
+{
+    if (std::holds_alternative<Json::JsonObjectNode>(node))
+    {
+        writeObject(std::get<Json::JsonObjectNode>(node));
+    }
+    else if (std::holds_alternative<Json::JsonListNode>(node))
+    {
+        writeList(std::get<Json::JsonListNode>(node));
+    }
+}
+
+void JsonSerializer::writeObject(const Json::JsonObjectNode& objNode)
+{
+    out.append('{');
+    bool first{true};
+    for (const auto& [k, v] : objNode)
+    {
+        if (!first)
+        {
+            out.append(',');
+        }
+        first = false;
+
+        writeString(k);
+        out.append(':');
+        writeValue(v);
+    }
+    out.append('}');
+}
+
+void JsonSerializer::writeList(const Json::JsonListNode& listNode)
+{
+    out.append('[');
+    bool first{true};
+    for (const auto& v : listNode)
+    {
+        if (!first)
+        {
+            out.append(',');
+        }
+        first = false;
+
+        writeValue(v);
+    }
+    out.append(']');
+}
+
+void JsonSerializer::writeValue(const Json::JsonFieldValue& value)
+{
+    if (value.isString())
+    {
+        writeString(value.getString());
+    }
+    else if (value.isBool())
+    {
+        writeBool(value.getBool());
+    }
+    else if (value.isNull())
+    {
+        writeNull();
+    }
+    else if (value.isInt())
+    {
+        writeInt(value.getInt());
+    }
+    else if (value.isDouble())
+    {
+        writeDouble(value.getDouble());
+    }
+    else if (value.isObject())
+    {
+        writeObject(value.getObject());
+    }
+    else if (value.isList())
+    {
+        writeList(value.getList());
+    }
+}
+
+void JsonSerializer::writeString(const std::string_view str)
+{
+    out.append('"');
+
+    /* Clean runs are found 16/32 bytes at a time and copied in one go, escapes are rare. */
+    const char* cursor = str.data();
+    uint64_t left = str.size();
+    while (true)
+    {
+        const uint64_t cleanRun = simd::findEscapable(cursor, left);
+        out.append(cursor, cleanRun);
+        if (cleanRun == left)
+        {
+            break;
+        }
+
+        writeEscapedChar(cursor[cleanRun]);
+        cursor += cleanRun + 1;
+        left -= cleanRun + 1;
+    }
+
+    out.append('"');
+}
+
+void JsonSerializer::writeEscapedChar(const char ch)
+{
+    const uint8_t byte = ch;
+    if (byte == '"' || byte == '\\')
+    {
+        const char escaped[2] = {'\\', ch};
+        out.append(escaped, 2);
+    }
+    else if (SHORT_ESCAPES[byte] != 0)
+    {
+        const char escaped[2] = {'\\', SHORT_ESCAPES[byte]};
+        out.append(escaped, 2);
+    }
+    else
+    {
+        const char escaped[6] = {'\\', 'u', '0', '0', HEX_DIGITS[byte >> 4], HEX_DIGITS[byte & 0xf]};
+        out.append(escaped, 6);
+    }
+}
+
+void JsonSerializer::writeInt(const int64_t number)
+{
+    /* Digits are produced back to front, 20 digits + sign is the worst case. */
+    char tmp[24];
+    char* const end = tmp + sizeof(tmp);
+    char* cursor = end;
+
+    uint64_t value = number < 0 ? 0 - (uint64_t)number : (uint64_t)number;
+    while (value >= 100)
+    {
+        const uint64_t pairIdx = (value % 100) * 2;
+        value /= 100;
+        cursor -= 2;
+        memcpy(cursor, DIGIT_PAIRS.data() + pairIdx, 2);
+    }
+
+    if (value >= 10)
+    {
+        cursor -= 2;
+        memcpy(cursor, DIGIT_PAIRS.data() + value * 2, 2);
+    }
+    else
+    {
+        *--cursor = '0' + value;
+    }
+
+    if (number < 0)
+    {
+        *--cursor = '-';
+    }
+
+    out.append(cursor, end - cursor);
+}
+
+void JsonSerializer::writeDouble(const double number)
+{
+    /* JSON has no representation for these. */
+    if (!std::isfinite(number))
+    {
+        writeNull();
+        return;
+    }
+
+    /* Shortest representation that parses back to the exact same double. */
+    char tmp[32];
+    const std::to_chars_result res = std::to_chars(tmp, tmp + sizeof(tmp), number);
+    const uint64_t size = res.ptr - tmp;
+
+    /* Keep a '.' in there so the parser reads it back as a double and not as an int. */
+    const char* exponent = (const char*)memchr(tmp, 'e', size);
+    if (memchr(tmp, '.', size) != nullptr)
+    {
+        out.append(tmp, size);
+    }
+    else if (exponent != nullptr)
+    {
+        out.append(tmp, exponent - tmp);
+        out.append(".0", 2);
+        out.append(exponent, tmp + size - exponent);
+    }
+    else
+    {
+        out.append(tmp, size);
+        out.append(".0", 2);
+    }
+}
+
+void JsonSerializer::writeBool(const bool value)
+{
+    if (value)
+    {
+        out.append("true", 4);
+    }
+    else
+    {
+        out.append("false", 5);
+    }
+}
+
+void JsonSerializer::writeNull()
+{
+    out.append("null", 4);
+}
+
+} // namespace hk
@@ -0,0 +1,36 @@
+#pragma once
+
+#include "HkJson.hpp"
+#include "OutputBuffer.hpp"
+
+namespace hk
+{
+
+/* Compact (no whitespace) JSON writer over an OutputBuffer.
+    - Literals, keys and string contents are copied as raw bytes, no format strings involved.
+    - Strings are escaped, only the bytes that need it leave the bulk copy path.
+    - Scalar emitters are public so other writers can reuse the exact same encoding.
+*/
+class JsonSerializer
+{
+public:
+    explicit JsonSerializer(OutputBuffer& out);
+
+    void write(const Json::JsonRootNode& node);
+    void writeObject(const Json::JsonObjectNode& objNode);
+    void writeList(const Json::JsonListNode& listNode);
+    void writeValue(const Json::JsonFieldValue& value);
+
+    void writeString(const std::string_view str);
+    void writeInt(const int64_t number);
+    void writeDouble(const double number);
+    void writeBool(const bool value);
+    void writeNull();
+
+private:
+    void writeEscapedChar(const char ch);
+
+    OutputBuffer& out;
+};
+
+} // namespace hk
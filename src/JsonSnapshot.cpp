@@ -0,0 +1,622 @@
+#include "JsonSnapshot.hpp"
+
+#include "JsonReader.hpp"
+#include "Utility.hpp"
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <unordered_map>
+#include <vector>
+
+namespace hk
+{
+
+namespace
+{
+constexpr uint8_t MAGIC[12] = {0xe9, 0x11, 0x00, 0xa8, 0x43, 0xa0, 0x41, 0x2d, 0x94, 0xb3, 0x06, 0xda};
+constexpr uint32_t VERSION{1};
+constexpr uint64_t HEADER_SIZE{32};
+constexpr uint64_t SLOT_SIZE{9};
+constexpr uint64_t ENTRY_SIZE{8 + SLOT_SIZE};
+
+enum Tag : uint8_t
+{
+    TAG_NULL,
+    TAG_FALSE,
+    TAG_TRUE,
+    TAG_INT,
+    TAG_DOUBLE,
+    TAG_STRING,
+    TAG_OBJECT,
+    TAG_LIST
+};
+
+/* Children are appended after their parent's record, parent slots get patched once the child offset is known. */
+class SnapshotEncoder
+{
+public:
+    JsonSnapshot::EncodeResult encode(const Json::JsonRootNode& root)
+    {
+        reserve(HEADER_SIZE);
+        memcpy(at(0), MAGIC, sizeof(MAGIC));
+        utils::storeBigEndian<uint32_t>(at(12), VERSION);
+
+        const uint64_t rootSlot = reserve(SLOT_SIZE);
+        if (std::holds_alternative<Json::JsonObjectNode>(root))
+        {
+            writeSlot(rootSlot, std::get<Json::JsonObjectNode>(root));
+        }
+        else
+        {
+            writeSlot(rootSlot, std::get<Json::JsonListNode>(root));
+        }
+
+        utils::storeBigEndian<uint64_t>(at(16), buffer.size());
+        utils::storeBigEndian<uint64_t>(at(24), rootSlot);
+        if (!error.empty())
+        {
+            return {.bytes = "", .error = error};
+        }
+        return {.bytes = std::move(buffer), .error = ""};
+    }
+
+private:
+    uint8_t* at(const uint64_t offset)
+    {
+        return (uint8_t*)buffer.data() + offset;
+    }
+
+    uint64_t reserve(const uint64_t bytes)
+    {
+        const uint64_t offset = buffer.size();
+        buffer.resize(offset + bytes);
+        return offset;
+    }
+
+    /* Lengths and counts are stored as u32. The first one that doesn't fit fails the whole encoding. */
+    bool fitsLength(const uint64_t length, const char* what)
+    {
+        if (length <= UINT32_MAX)
+        {
+            return true;
+        }
+        if (error.empty())
+        {
+            error = "Snapshot length field overflow";
+            sprint(error, "Snapshot can't hold a %s of %lu entries/bytes (u32 max)", what, length);
+        }
+        return false;
+    }
+
+    uint64_t writeString(const std::string_view str)
+    {
+        if (!fitsLength(str.size(), "string"))
+        {
+            return 0;
+        }
+        const uint64_t offset = reserve(4 + str.size());
+        utils::storeBigEndian<uint32_t>(at(offset), str.size());
+        memcpy(at(offset + 4), str.data(), str.size());
+        return offset;
+    }
+
+    /* Keys repeat a lot across records of the same shape, store each distinct one once. */
+    uint64_t writeKey(const std::string& key)
+    {
+        const auto it = keyOffsets.find(key);
+        if (it != keyOffsets.end())
+        {
+            return it->second;
+        }
+        const uint64_t offset = writeString(key);
+        keyOffsets.emplace(key, offset);
+        return offset;
+    }
+
+    void setSlot(const uint64_t slot, const uint8_t tag, const uint64_t payload)
+    {
+        *at(slot) = tag;
+        utils::storeBigEndian<uint64_t>(at(slot + 1), payload);
+    }
+
+    void writeSlot(const uint64_t slot, const Json::JsonObjectNode& objNode)
+    {
+        std::vector<const std::pair<const std::string, Json::JsonFieldValue>*> entries;
+        entries.reserve(objNode.size());
+        for (const auto& entry : objNode)
+        {
+            entries.push_back(&entry);
+        }
+        std::sort(entries.begin(), entries.end(), [](const auto* lhs, const auto* rhs)
+        {
+            return lhs->first < rhs->first;
+        });
+
+        if (!fitsLength(entries.size(), "object"))
+        {
+            return;
+        }
+        const uint64_t record = reserve(4 + entries.size() * ENTRY_SIZE);
+        utils::storeBigEndian<uint32_t>(at(record), entries.size());
+        setSlot(slot, TAG_OBJECT, record);
+
+        for (uint64_t i{0}; i < entries.size(); i++)
+        {
+            const uint64_t entry = record + 4 + i * ENTRY_SIZE;
+            const uint64_t keyOffset = writeKey(entries[i]->first);
+            utils::storeBigEndian<uint64_t>(at(entry), keyOffset);
+            writeSlot(entry + 8, entries[i]->second);
+        }
+    }
+
+    void writeSlot(const uint64_t slot, const Json::JsonListNode& listNode)
+    {
+        if (!fitsLength(listNode.size(), "list"))
+        {
+            return;
+        }
+        const uint64_t record = reserve(4 + listNode.size() * SLOT_SIZE);
+        utils::storeBigEndian<uint32_t>(at(record), listNode.size());
+        setSlot(slot, TAG_LIST, record);
+
+        for (uint64_t i{0}; i < listNode.size(); i++)
+        {
+            writeSlot(record + 4 + i * SLOT_SIZE, listNode[i]);
+        }
+    }
+
+    void writeSlot(const uint64_t slot, const Json::JsonFieldValue& value)
+    {
+        if (value.isNull())
+        {
+            setSlot(slot, TAG_NULL, 0);
+        }
+        else if (value.isBool())
+        {
+            setSlot(slot, value.getBool() ? TAG_TRUE : TAG_FALSE, 0);
+        }
+        else if (value.isInt())
+        {
+            setSlot(slot, TAG_INT, (uint64_t)value.getInt());
+        }
+        else if (value.isDouble())
+        {
+            setSlot(slot, TAG_DOUBLE, std::bit_cast<uint64_t>(value.getDouble()));
+        }
+        else if (value.isString())
+        {
+            const uint64_t offset = writeString(value.getString());
+            setSlot(slot, TAG_STRING, offset);
+        }
+        else if (value.isObject())
+        {
+            writeSlot(slot, value.getObject());
+        }
+        else if (value.isList())
+        {
+            writeSlot(slot, value.getList());
+        }
+    }
+
+    std::string buffer;
+    std::unordered_map<std::string, uint64_t> keyOffsets;
+    std::string error;
+};
+} // namespace
+
+SnapshotValue::SnapshotValue(const uint8_t* snapshotBase, const uint64_t snapshotSize, const uint64_t slot)
+    : base{snapshotBase}
+    , size_{snapshotSize}
+    , slotOffset{slot}
+{}
+
+bool SnapshotValue::exists() const
+{
+    /* Subtraction form throughout: offsets come from the file and a sum could wrap around. */
+    return base != nullptr && size_ >= SLOT_SIZE && slotOffset <= size_ - SLOT_SIZE;
+}
+
+bool SnapshotValue::isNull() const
+{
+    return exists() && getTag() == TAG_NULL;
+}
+
+bool SnapshotValue::isBool() const
+{
+    return exists() && (getTag() == TAG_TRUE || getTag() == TAG_FALSE);
+}
+
+bool SnapshotValue::isInt() const
+{
+    return exists() && getTag() == TAG_INT;
+}
+
+bool SnapshotValue::isDouble() const
+{
+    return exists() && getTag() == TAG_DOUBLE;
+}
+
+bool SnapshotValue::isString() const
+{
+    return exists() && getTag() == TAG_STRING;
+}
+
+bool SnapshotValue::isObject() const
+{
+    return exists() && getTag() == TAG_OBJECT;
+}
+
+bool SnapshotValue::isList() const
+{
+    return exists() && getTag() == TAG_LIST;
+}
+
+bool SnapshotValue::getBool() const
+{
+    return exists() && getTag() == TAG_TRUE;
+}
+
+int64_t SnapshotValue::getInt() const
+{
+    return isInt() ? (int64_t)getPayload() : 0;
+}
+
+double SnapshotValue::getDouble() const
+{
+    return isDouble() ? std::bit_cast<double>(getPayload()) : 0.0;
+}
+
+std::string_view SnapshotValue::getString() const
+{
+    const uint64_t record = recordOffset(TAG_STRING);
+    if (record == 0)
+    {
+        return {};
+    }
+
+    const uint32_t length = utils::loadBigEndian<uint32_t>(base + record);
+    if (length > size_ - 4 - record)
+    {
+        return {};
+    }
+    return {(const char*)base + record + 4, length};
+}
+
+uint32_t SnapshotValue::size() const
+{
+    uint64_t record = recordOffset(TAG_OBJECT);
+    if (record == 0)
+    {
+        record = recordOffset(TAG_LIST);
+    }
+    return record == 0 ? 0 : utils::loadBigEndian<uint32_t>(base + record);
+}
+
+SnapshotValue SnapshotValue::operator[](const std::string_view key) const
+{
+    const uint64_t record = recordOffset(TAG_OBJECT);
+    if (record == 0)
+    {
+        return {};
+    }
+
+    /* Keys were sorted at encode time, binary search them in place. */
+    uint64_t low{0};
+    uint64_t high = utils::loadBigEndian<uint32_t>(base + record);
+    while (low < high)
+    {
+        const uint64_t mid = low + (high - low) / 2;
+        const int32_t cmp = keyAt(mid).compare(key);
+        if (cmp == 0)
+        {
+            return valueAt(mid);
+        }
+        cmp < 0 ? low = mid + 1 : high = mid;
+    }
+    return {};
+}
+
+SnapshotValue SnapshotValue::operator[](const uint64_t index) const
+{
+    const uint64_t record = recordOffset(TAG_LIST);
+    if (record == 0 || index >= utils::loadBigEndian<uint32_t>(base + record))
+    {
+        return {};
+    }
+    return {base, size_, record + 4 + index * SLOT_SIZE};
+}
+
+std::string_view SnapshotValue::keyAt(const uint64_t index) const
+{
+    const uint64_t record = recordOffset(TAG_OBJECT);
+    if (record == 0 || index >= utils::loadBigEndian<uint32_t>(base + record))
+    {
+        return {};
+    }
+
+    const uint64_t keyRecord = utils::loadBigEndian<uint64_t>(base + record + 4 + index * ENTRY_SIZE);
+    if (keyRecord < HEADER_SIZE || keyRecord > size_ - 4 ||
+        utils::loadBigEndian<uint32_t>(base + keyRecord) > size_ - 4 - keyRecord)
+    {
+        return {};
+    }
+    return {(const char*)base + keyRecord + 4, utils::loadBigEndian<uint32_t>(base + keyRecord)};
+}
+
+SnapshotValue SnapshotValue::valueAt(const uint64_t index) const
+{
+    const uint64_t record = recordOffset(TAG_OBJECT);
+    if (record == 0 || index >= utils::loadBigEndian<uint32_t>(base + record))
+    {
+        return {};
+    }
+    return {base, size_, record + 4 + index * ENTRY_SIZE + 8};
+}
+
+std::string SnapshotValue::toFieldValue(Json::JsonFieldValue& out) const
+{
+    return toFieldValue(out, 0) ? "" : "Snapshot nested too deep";
+}
+
+bool SnapshotValue::toFieldValue(Json::JsonFieldValue& out, const uint32_t depth) const
+{
+    if (isBool())
+    {
+        out = getBool();
+    }
+    else if (isInt())
+    {
+        out = getInt();
+    }
+    else if (isDouble())
+    {
+        out = getDouble();
+    }
+    else if (isString())
+    {
+        out = std::string{getString()};
+    }
+    else if (isObject() || isList())
+    {
+        /* Records only ever point forward so this can't loop, but a crafted file can still nest deep enough to
+           overflow the stack. */
+        if (depth > JsonReader::MAX_DEPTH)
+        {
+            return false;
+        }
+
+        const uint32_t count = size();
+        if (isObject())
+        {
+            Json::JsonObjectNode objNode;
+            objNode.reserve(count);
+            for (uint32_t i{0}; i < count; i++)
+            {
+                Json::JsonFieldValue value;
+                if (!valueAt(i).toFieldValue(value, depth + 1))
+                {
+                    return false;
+                }
+                objNode.emplace(keyAt(i), std::move(value));
+            }
+            out = std::move(objNode);
+        }
+        else
+        {
+            Json::JsonListNode listNode;
+            listNode.reserve(count);
+            for (uint32_t i{0}; i < count; i++)
+            {
+                if (!(*this)[i].toFieldValue(listNode.emplace_back(), depth + 1))
+                {
+                    return false;
+                }
+            }
+            out = std::move(listNode);
+        }
+    }
+    else
+    {
+        out = Json::JsonNull{};
+    }
+    return true;
+}
+
+uint8_t SnapshotValue::getTag() const
+{
+    return base[slotOffset];
+}
+
+uint64_t SnapshotValue::getPayload() const
+{
+    return utils::loadBigEndian<uint64_t>(base + slotOffset + 1);
+}
+
+uint64_t SnapshotValue::recordOffset(const uint8_t expectedTag) const
+{
+    if (!exists() || getTag() != expectedTag)
+    {
+        return 0;
+    }
+
+    /* Corrupted offsets are treated like missing values instead of reading out of bounds. Records always follow
+       the slot pointing at them, one that doesn't could make a container its own descendant. */
+    const uint64_t record = getPayload();
+    if (size_ < HEADER_SIZE + 4 || record < HEADER_SIZE || record <= slotOffset || record > size_ - 4)
+    {
+        return 0;
+    }
+
+    const uint64_t count = utils::loadBigEndian<uint32_t>(base + record);
+    const uint64_t itemSize = expectedTag == TAG_OBJECT ? ENTRY_SIZE : (expectedTag == TAG_LIST ? SLOT_SIZE : 0);
+    if (count * itemSize > size_ - 4 - record)
+    {
+        return 0;
+    }
+    return record;
+}
+
+JsonSnapshot::~JsonSnapshot()
+{
+    if (mapped)
+    {
+        munmap((void*)data, size);
+    }
+}
+
+JsonSnapshot::EncodeResult JsonSnapshot::encode(const Json::JsonRootNode& root)
+{
+    return SnapshotEncoder{}.encode(root);
+}
+
+std::string JsonSnapshot::writeToFile(const Json::JsonRootNode& root, const std::string& path)
+{
+    const EncodeResult encoded = encode(root);
+    if (!encoded.error.empty())
+    {
+        return encoded.error;
+    }
+
+    std::ofstream file{path, std::ios::binary | std::ios::trunc};
+    file.write(encoded.bytes.data(), encoded.bytes.size());
+    if (file.fail())
+    {
+        std::string errBuff;
+        sprint(errBuff, "Failed to write snapshot: %s", path.c_str());
+        return errBuff;
+    }
+    return "";
+}
+
+JsonSnapshot::LoadResult JsonSnapshot::mapFile(const std::string& path)
+{
+    std::string errBuff;
+
+    /* Cheap rejection of anything that isn't a snapshot before setting up the mapping. */
+    std::ifstream probe{path, std::ios::binary};
+    if (probe.fail())
+    {
+        sprint(errBuff, "Failed to load: %s", path.c_str());
+        return {nullptr, errBuff};
+    }
+    if (!utils::isMagicNumberNext(probe))
+    {
+        sprint(errBuff, "Not a snapshot file (bad magic number): %s", path.c_str());
+        return {nullptr, errBuff};
+    }
+    probe.close();
+
+    const int32_t fd = open(path.c_str(), O_RDONLY);
+    struct stat fileStat{};
+    if (fd < 0 || fstat(fd, &fileStat) != 0)
+    {
+        if (fd >= 0)
+        {
+            close(fd);
+        }
+        sprint(errBuff, "Failed to load: %s", path.c_str());
+        return {nullptr, errBuff};
+    }
+
+    void* mapping = mmap(nullptr, fileStat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED)
+    {
+        sprint(errBuff, "Failed to map: %s", path.c_str());
+        return {nullptr, errBuff};
+    }
+
+    std::shared_ptr<JsonSnapshot> snapshot{new JsonSnapshot{}};
+    snapshot->data = (const uint8_t*)mapping;
+    snapshot->size = fileStat.st_size;
+    snapshot->mapped = true;
+
+    const std::string error = validate(snapshot->data, snapshot->size);
+    if (!error.empty())
+    {
+        return {nullptr, error};
+    }
+    return {snapshot, ""};
+}
+
+JsonSnapshot::LoadResult JsonSnapshot::fromBytes(std::string bytes)
+{
+    std::shared_ptr<JsonSnapshot> snapshot{new JsonSnapshot{}};
+    snapshot->ownedBytes = std::move(bytes);
+    snapshot->data = (const uint8_t*)snapshot->ownedBytes.data();
+    snapshot->size = snapshot->ownedBytes.size();
+
+    const std::string error = validate(snapshot->data, snapshot->size);
+    if (!error.empty())
+    {
+        return {nullptr, error};
+    }
+    return {snapshot, ""};
+}
+
+SnapshotValue JsonSnapshot::root() const
+{
+    return {data, size, utils::loadBigEndian<uint64_t>(data + 24)};
+}
+
+Json::JsonResult JsonSnapshot::toRootNode() const
+{
+    Json::JsonFieldValue rootValue;
+    const std::string error = root().toFieldValue(rootValue);
+    if (!error.empty())
+    {
+        return {.json = nullptr, .error = error};
+    }
+    if (rootValue.isList())
+    {
+        return {.json = std::make_shared<Json::JsonRootNode>(std::move(rootValue.getList())), .error = ""};
+    }
+    return {.json = std::make_shared<Json::JsonRootNode>(std::move(rootValue.getObject())), .error = ""};
+}
+
+std::string_view JsonSnapshot::bytes() const
+{
+    return {(const char*)data, size};
+}
+
+std::string JsonSnapshot::validate(const uint8_t* bytes, const uint64_t byteCount)
+{
+    if (byteCount < HEADER_SIZE + SLOT_SIZE || memcmp(bytes, MAGIC, sizeof(MAGIC)) != 0)
+    {
+        return "Not a snapshot (bad magic number or truncated header)";
+    }
+
+    std::string errBuff;
+    if (utils::loadBigEndian<uint32_t>(bytes + 12) != VERSION)
+    {
+        sprint(errBuff, "Unsupported snapshot version %u", utils::loadBigEndian<uint32_t>(bytes + 12));
+        return errBuff;
+    }
+
+    if (utils::loadBigEndian<uint64_t>(bytes + 16) != byteCount)
+    {
+        const uint64_t headerSize = utils::loadBigEndian<uint64_t>(bytes + 16);
+        sprint(errBuff, "Snapshot size mismatch, header says %lu but got %lu", headerSize, byteCount);
+        return errBuff;
+    }
+
+    const uint64_t rootSlot = utils::loadBigEndian<uint64_t>(bytes + 24);
+    const SnapshotValue rootValue{bytes, byteCount, rootSlot};
+    if (!rootValue.isObject() && !rootValue.isList())
+    {
+        return "Snapshot root must be an object or a list";
+    }
+    /* Same rule the accessors apply below the root: a record never comes before the slot pointing at it. */
+    const uint64_t rootRecord = utils::loadBigEndian<uint64_t>(bytes + rootSlot + 1);
+    if (rootRecord <= rootSlot || rootRecord > byteCount - 4)
+    {
+        return "Snapshot root record out of place";
+    }
+    return "";
+}
+
+} // namespace hk
@@ -0,0 +1,139 @@
+#pragma once
+
+#include "HkJson.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+
+namespace hk
+{
+
+/* Binary snapshot of a parsed document that can be memory mapped and queried in place.
+
+    Layout (all integers big endian, all offsets relative to the start of the snapshot):
+    - header: magic e91100a843a0412d94b306da | u32 version | u64 total size | u64 root slot offset
+    - slot:   u8 tag | u64 payload (int/double bits, or offset of a string/list/object record)
+    - string: u32 length | bytes
+    - list:   u32 count | count * slot
+    - object: u32 count | count * (u64 key string offset | slot), sorted by key for binary search
+
+    Nothing in it is a pointer, so the same bytes work wherever they get mapped. Every record comes after the slot
+    pointing at it, readers treat anything else as corrupted so a snapshot can't loop back on itself.
+*/
+class SnapshotValue
+{
+public:
+    SnapshotValue() = default;
+    SnapshotValue(const uint8_t* base, const uint64_t size, const uint64_t slotOffset);
+
+    /**
+        @brief False for values obtained through a missing key or an out of range index.
+    */
+    bool exists() const;
+
+    bool isNull() const;
+    bool isBool() const;
+    bool isInt() const;
+    bool isDouble() const;
+    bool isString() const;
+    bool isObject() const;
+    bool isList() const;
+
+    bool getBool() const;
+    int64_t getInt() const;
+    double getDouble() const;
+    std::string_view getString() const;
+
+    /**
+        @brief Number of entries for objects and lists, 0 otherwise.
+    */
+    uint32_t size() const;
+
+    SnapshotValue operator[](const std::string_view key) const;
+    SnapshotValue operator[](const uint64_t index) const;
+
+    /**
+        @brief Key of the _index_th object entry. Entries are sorted by key.
+    */
+    std::string_view keyAt(const uint64_t index) const;
+    SnapshotValue valueAt(const uint64_t index) const;
+
+    /**
+        @brief Materialize this value (and everything below it) back into a DOM value in _out_. Returns empty string
+            on success, an error if containers nest deeper than JsonReader::MAX_DEPTH.
+    */
+    std::string toFieldValue(Json::JsonFieldValue& out) const;
+
+private:
+    uint8_t getTag() const;
+    uint64_t getPayload() const;
+    uint64_t recordOffset(const uint8_t expectedTag) const;
+    bool toFieldValue(Json::JsonFieldValue& out, const uint32_t depth) const;
+
+    const uint8_t* base{nullptr};
+    uint64_t size_{0};
+    uint64_t slotOffset{0};
+};
+
+class JsonSnapshot
+{
+public:
+    struct LoadResult
+    {
+        std::shared_ptr<const JsonSnapshot> snapshot;
+        const std::string error;
+    };
+
+    struct EncodeResult
+    {
+        std::string bytes;
+        const std::string error;
+    };
+
+    JsonSnapshot(const JsonSnapshot&) = delete;
+    JsonSnapshot& operator=(const JsonSnapshot&) = delete;
+    ~JsonSnapshot();
+
+    /**
+        @brief Encode _root_ into snapshot bytes. Fails if a string, list or object is too big for its u32 length
+            field.
+    */
+    static EncodeResult encode(const Json::JsonRootNode& root);
+
+    /**
+        @brief Encode _root_ and write it to _path_. Returns empty string on success.
+    */
+    static std::string writeToFile(const Json::JsonRootNode& root, const std::string& path);
+
+    /**
+        @brief Memory map the snapshot at _path_. Nothing is parsed or copied.
+    */
+    static LoadResult mapFile(const std::string& path);
+
+    /**
+        @brief Take ownership of snapshot bytes already in memory.
+    */
+    static LoadResult fromBytes(std::string bytes);
+
+    SnapshotValue root() const;
+
+    /**
+        @brief Materialize the whole snapshot back into a regular document.
+    */
+    Json::JsonResult toRootNode() const;
+
+    std::string_view bytes() const;
+
+private:
+    JsonSnapshot() = default;
+    static std::string validate(const uint8_t* data, const uint64_t size);
+
+    std::string ownedBytes;
+    const uint8_t* data{nullptr};
+    uint64_t size{0};
+    bool mapped{false};
+};
+
+} // namespace hk
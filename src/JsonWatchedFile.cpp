@@ -0,0 +1,171 @@
+#include "JsonWatchedFile.hpp"
+
+#include "Utility.hpp"
+#include <climits>
+#include <cstring>
+#include <filesystem>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+namespace hk
+{
+
+namespace
+{
+/* Writes finishing in place, or another file renamed over ours. */
+constexpr uint32_t WATCHED_EVENTS{IN_CLOSE_WRITE | IN_MOVED_TO};
+} // namespace
+
+JsonWatchedFile::JsonWatchedFile(const std::string& filePath, JsonReclaimer* const freeingReclaimer)
+    : path{filePath}
+    , reclaimer{freeingReclaimer}
+{}
+
+JsonWatchedFile::OpenResult JsonWatchedFile::open(const std::string& path, JsonReclaimer* const reclaimer)
+{
+    std::unique_ptr<JsonWatchedFile> watched{new JsonWatchedFile{path, reclaimer}};
+
+    /* Watch first, load second: a change landing while the first load runs is then queued for the watcher
+       instead of being lost. */
+    const std::filesystem::path fsPath{path};
+    watched->fileName = fsPath.filename().string();
+    const std::string directory = fsPath.has_parent_path() ? fsPath.parent_path().string() : ".";
+
+    watched->inotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    watched->stopFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (watched->inotifyFd < 0 || watched->stopFd < 0 ||
+        inotify_add_watch(watched->inotifyFd, directory.c_str(), WATCHED_EVENTS) < 0)
+    {
+        std::string errBuff;
+        sprint(errBuff, "Failed to watch %s: %s", directory.c_str(), strerror(errno));
+        return {.watched = nullptr, .error = errBuff};
+    }
+
+    Json json;
+    Json::JsonResult first = json.loadFromFile(path);
+    if (!first.error.empty())
+    {
+        return {.watched = nullptr, .error = first.error};
+    }
+    watched->publish(std::move(first.json));
+
+    watched->watcher = std::thread{&JsonWatchedFile::watchLoop, watched.get()};
+    return {.watched = std::move(watched), .error = ""};
+}
+
+JsonWatchedFile::~JsonWatchedFile()
+{
+    if (watcher.joinable())
+    {
+        const uint64_t wake{1};
+        (void)!write(stopFd, &wake, sizeof(wake));
+        watcher.join();
+    }
+
+    if (inotifyFd >= 0)
+    {
+        close(inotifyFd);
+    }
+    if (stopFd >= 0)
+    {
+        close(stopFd);
+    }
+}
+
+std::shared_ptr<const Json::JsonRootNode> JsonWatchedFile::current() const
+{
+    return document.load(std::memory_order_acquire);
+}
+
+uint64_t JsonWatchedFile::version() const
+{
+    return versions.load(std::memory_order_acquire);
+}
+
+std::string JsonWatchedFile::lastError() const
+{
+    std::lock_guard<std::mutex> lock{errorMutex};
+    return error;
+}
+
+void JsonWatchedFile::watchLoop()
+{
+    pollfd fds[2]{
+        {.fd = inotifyFd, .events = POLLIN, .revents = 0},
+        {.fd = stopFd, .events = POLLIN, .revents = 0},
+    };
+
+    while (true)
+    {
+        if (poll(fds, 2, -1) < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            return;
+        }
+        if (fds[1].revents != 0)
+        {
+            return;
+        }
+        if (fds[0].revents != 0 && drainEvents())
+        {
+            reload();
+        }
+    }
+}
+
+bool JsonWatchedFile::drainEvents()
+{
+    alignas(inotify_event) char buffer[4096 + sizeof(inotify_event) + NAME_MAX + 1];
+    bool touched{false};
+    while (true)
+    {
+        const ssize_t readBytes = read(inotifyFd, buffer, sizeof(buffer));
+        if (readBytes <= 0)
+        {
+            return touched;
+        }
+
+        for (ssize_t offset{0}; offset < readBytes;)
+        {
+            const inotify_event* event = (const inotify_event*)(buffer + offset);
+            if ((event->mask & WATCHED_EVENTS) != 0 && event->len > 0 && fileName == event->name)
+            {
+                touched = true;
+            }
+            offset += sizeof(inotify_event) + event->len;
+        }
+    }
+}
+
+void JsonWatchedFile::reload()
+{
+    Json json;
+    Json::JsonResult result = json.loadFromFile(path);
+    {
+        std::lock_guard<std::mutex> lock{errorMutex};
+        error = result.error;
+    }
+    if (!result.error.empty())
+    {
+        return;
+    }
+
+    publish(std::move(result.json));
+}
+
+void JsonWatchedFile::publish(Json::JsonNodeSPtr&& json)
+{
+    if (reclaimer != nullptr)
+    {
+        json = reclaimer->adopt(std::move(*json));
+    }
+    document.store(std::move(json), std::memory_order_release);
+    versions.fetch_add(1, std::memory_order_acq_rel);
+}
+
+} // namespace hk
@@ -0,0 +1,86 @@
+#pragma once
+
+#include "HkJson.hpp"
+#include "JsonReclaimer.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace hk
+{
+
+/* JSON file kept up to date in the background, for configs that change while the process runs.
+    - The directory is watched with inotify so files replaced through rename (what editors and deploy tools do)
+      are picked up too, not only writes in place. Bursts of events are drained before parsing once.
+    - A background thread parses the new version and publishes it with a single atomic store, RCU style: readers
+      keep whatever version they got for as long as they hold it, the old one goes away with its last reader.
+      Readers never wait for a parse.
+    - A file that fails to parse leaves the previous version in place, the reason is kept in lastError().
+    - Given a JsonReclaimer, replaced versions are freed on its threads instead of by whichever reader lets go of
+      them last. The reclaimer must outlive this object and every document obtained from it.
+    - Linux only (inotify, eventfd).
+
+    JsonWatchedFile::OpenResult config = JsonWatchedFile::open("config.json");
+    std::shared_ptr<const Json::JsonRootNode> now = config.watched->current();
+*/
+class JsonWatchedFile
+{
+public:
+    struct OpenResult
+    {
+        std::unique_ptr<JsonWatchedFile> watched;
+        const std::string error;
+    };
+
+    /**
+        @brief Start watching _path_, then load it once. Fails if the watch can't be set up or the first load fails.
+    */
+    static OpenResult open(const std::string& path, JsonReclaimer* reclaimer = nullptr);
+
+    JsonWatchedFile(const JsonWatchedFile&) = delete;
+    JsonWatchedFile& operator=(const JsonWatchedFile&) = delete;
+    ~JsonWatchedFile();
+
+    /**
+        @brief Latest successfully parsed version. Never null.
+    */
+    std::shared_ptr<const Json::JsonRootNode> current() const;
+
+    /**
+        @brief Number of versions published so far, 1 right after open().
+    */
+    uint64_t version() const;
+
+    /**
+        @brief Why the last reload failed, empty if it succeeded.
+    */
+    std::string lastError() const;
+
+private:
+    JsonWatchedFile(const std::string& path, JsonReclaimer* reclaimer);
+
+    void watchLoop();
+    bool drainEvents();
+    void reload();
+    void publish(Json::JsonNodeSPtr&& json);
+
+    const std::string path;
+    std::string fileName;
+    int32_t inotifyFd{-1};
+    int32_t stopFd{-1};
+    JsonReclaimer* const reclaimer;
+
+    std::atomic<std::shared_ptr<const Json::JsonRootNode>> document;
+    std::atomic<uint64_t> versions{0};
+
+    mutable std::mutex errorMutex;
+    std::string error;
+
+    std::thread watcher;
+};
+
+} // namespace hk
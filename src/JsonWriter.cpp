@@ -0,0 +1,169 @@
+#include "JsonWriter.hpp"
+
+#include <cassert>
+
+namespace hk
+{
+
+JsonWriter::JsonWriter(OutputBuffer& outBuffer)
+    : out{outBuffer}
+    , serializer{outBuffer}
+{}
+
+JsonWriter& JsonWriter::beginObject()
+{
+    beginScope(Scope::OBJECT);
+    out.append('{');
+    return *this;
+}
+
+JsonWriter& JsonWriter::endObject()
+{
+    endScope(Scope::OBJECT);
+    out.append('}');
+    return *this;
+}
+
+JsonWriter& JsonWriter::beginArray()
+{
+    beginScope(Scope::ARRAY);
+    out.append('[');
+    return *this;
+}
+
+JsonWriter& JsonWriter::endArray()
+{
+    endScope(Scope::ARRAY);
+    out.append(']');
+    return *this;
+}
+
+JsonWriter& JsonWriter::key(const std::string_view name)
+{
+#ifndef NDEBUG
+    assert(!scopes.empty() && scopes.back() == Scope::OBJECT && "JsonWriter: key() is only valid inside an object");
+    assert(!keyPending && "JsonWriter: key() called twice without a value in between");
+    keyPending = true;
+#endif
+
+    if (needsComma)
+    {
+        out.append(',');
+    }
+    serializer.writeString(name);
+    out.append(':');
+    needsComma = false;
+    return *this;
+}
+
+JsonWriter& JsonWriter::value(const std::string_view str)
+{
+    beforeValue();
+    serializer.writeString(str);
+    return *this;
+}
+
+JsonWriter& JsonWriter::value(const char* str)
+{
+    return value(std::string_view{str});
+}
+
+JsonWriter& JsonWriter::value(const std::string& str)
+{
+    return value(std::string_view{str});
+}
+
+JsonWriter& JsonWriter::value(const bool boolean)
+{
+    beforeValue();
+    serializer.writeBool(boolean);
+    return *this;
+}
+
+JsonWriter& JsonWriter::value(const int32_t number)
+{
+    return value((int64_t)number);
+}
+
+JsonWriter& JsonWriter::value(const int64_t number)
+{
+    beforeValue();
+    serializer.writeInt(number);
+    return *this;
+}
+
+JsonWriter& JsonWriter::value(const double number)
+{
+    beforeValue();
+    serializer.writeDouble(number);
+    return *this;
+}
+
+JsonWriter& JsonWriter::value(const Json::JsonNull)
+{
+    beforeValue();
+    serializer.writeNull();
+    return *this;
+}
+
+JsonWriter& JsonWriter::value(const Json::JsonFieldValue& fieldValue)
+{
+    beforeValue();
+    serializer.writeValue(fieldValue);
+    return *this;
+}
+
+bool JsonWriter::isComplete() const
+{
+    return depth == 0 && rootWritten;
+}
+
+void JsonWriter::beforeValue()
+{
+#ifndef NDEBUG
+    assert(!(depth == 0 && rootWritten) && "JsonWriter: only one root value can be written");
+    if (!scopes.empty() && scopes.back() == Scope::OBJECT)
+    {
+        assert(keyPending && "JsonWriter: values inside an object need a key() first");
+    }
+    keyPending = false;
+#endif
+
+    if (needsComma)
+    {
+        out.append(',');
+    }
+
+    /* Whatever comes next at this level is a sibling. Containers reset this when they open. */
+    needsComma = depth > 0;
+    rootWritten = rootWritten || depth == 0;
+}
+
+void JsonWriter::beginScope(const Scope scope)
+{
+    beforeValue();
+    depth++;
+    needsComma = false;
+
+#ifndef NDEBUG
+    scopes.push_back(scope);
+#else
+    (void)scope;
+#endif
+}
+
+void JsonWriter::endScope(const Scope scope)
+{
+#ifndef NDEBUG
+    assert(!scopes.empty() && scopes.back() == scope && "JsonWriter: end call doesn't match the open container");
+    assert(!keyPending && "JsonWriter: container closed while a key still waits for its value");
+    scopes.pop_back();
+#else
+    (void)scope;
+#endif
+
+    depth--;
+    needsComma = depth > 0;
+}
+
+} // namespace hk
@@ -0,0 +1,73 @@
+#pragma once
+
+#include "HkJson.hpp"
+#include "JsonSerializer.hpp"
+#include "OutputBuffer.hpp"
+
+#include <string_view>
+#include <vector>
+
+namespace hk
+{
+
+/* Streaming JSON writer, emits straight into an OutputBuffer without building a DOM.
+    - Commas and ':' are placed automatically.
+    - Debug builds (no NDEBUG) assert on bad nesting: key outside objects, value without key,
+      mismatched end calls or more than one root.
+
+    writer.beginObject().key("id").value(1001).key("tags").beginArray().value("a").endArray().endObject();
+*/
+class JsonWriter
+{
+public:
+    explicit JsonWriter(OutputBuffer& out);
+
+    JsonWriter& beginObject();
+    JsonWriter& endObject();
+    JsonWriter& beginArray();
+    JsonWriter& endArray();
+    JsonWriter& key(const std::string_view name);
+
+    JsonWriter& value(const std::string_view str);
+    JsonWriter& value(const char* str);
+    JsonWriter& value(const std::string& str);
+    JsonWriter& value(const bool boolean);
+    JsonWriter& value(const int32_t number);
+    JsonWriter& value(const int64_t number);
+    JsonWriter& value(const double number);
+    JsonWriter& value(const Json::JsonNull);
+
+    /**
+        @brief Embed an already built DOM value (object/list subtrees included).
+    */
+    JsonWriter& value(const Json::JsonFieldValue& fieldValue);
+
+    /**
+        @brief True once exactly one root value has been fully written.
+    */
+    bool isComplete() const;
+
+private:
+    enum class Scope : uint8_t
+    {
+        OBJECT,
+        ARRAY
+    };
+
+    void beforeValue();
+    void beginScope(const Scope scope);
+    void endScope(const Scope scope);
+
+    OutputBuffer& out;
+    JsonSerializer serializer;
+    bool needsComma{false};
+    uint32_t depth{0};
+    bool rootWritten{false};
+
+#ifndef NDEBUG
+    std::vector<Scope> scopes;
+    bool keyPending{false};
+#endif
+};
+
+} // namespace hk
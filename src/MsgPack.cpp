@@ -0,0 +1,444 @@
+#include "MsgPack.hpp"
+
+#include "Utility.hpp"
+#include <algorithm>
+#include <bit>
+
+namespace hk
+{
+
+namespace
+{
+/* Untrusted input can nest arbitrarily deep, don't let it take the stack down. */
+constexpr uint32_t MAX_DEPTH{512};
+/* Counts come from the input too, never pre-allocate more than this up front. */
+constexpr uint64_t MAX_RESERVE{4096};
+
+void encodeString(const std::string_view str, OutputBuffer& out)
+{
+    const uint64_t size = str.size();
+    if (size < 32)
+    {
+        out.append((char)(0xa0 | size));
+    }
+    else if (size <= 0xff)
+    {
+        out.append((char)0xd9);
+        out.appendBigEndian(size, 1);
+    }
+    else if (size <= 0xffff)
+    {
+        out.append((char)0xda);
+        out.appendBigEndian(size, 2);
+    }
+    else
+    {
+        out.append((char)0xdb);
+        out.appendBigEndian(size, 4);
+    }
+    out.append(str);
+}
+
+void encodeInt(const int64_t number, OutputBuffer& out)
+{
+    if (number >= 0)
+    {
+        if (number < 128)
+        {
+            out.append((char)number);
+        }
+        else if (number <= 0xff)
+        {
+            out.append((char)0xcc);
+            out.appendBigEndian(number, 1);
+        }
+        else if (number <= 0xffff)
+        {
+            out.append((char)0xcd);
+            out.appendBigEndian(number, 2);
+        }
+        else if (number <= 0xffffffff)
+        {
+            out.append((char)0xce);
+            out.appendBigEndian(number, 4);
+        }
+        else
+        {
+            out.append((char)0xcf);
+            out.appendBigEndian(number, 8);
+        }
+    }
+    else
+    {
+        if (number >= -32)
+        {
+            out.append((char)number);
+        }
+        else if (number >= INT8_MIN)
+        {
+            out.append((char)0xd0);
+            out.appendBigEndian((uint64_t)number, 1);
+        }
+        else if (number >= INT16_MIN)
+        {
+            out.append((char)0xd1);
+            out.appendBigEndian((uint64_t)number, 2);
+        }
+        else if (number >= INT32_MIN)
+        {
+            out.append((char)0xd2);
+            out.appendBigEndian((uint64_t)number, 4);
+        }
+        else
+        {
+            out.append((char)0xd3);
+            out.appendBigEndian((uint64_t)number, 8);
+        }
+    }
+}
+
+void encodeContainerHead(const uint64_t count,
+    const uint8_t fixBase,
+    const uint8_t code16,
+    const uint8_t code32,
+    OutputBuffer& out)
+{
+    if (count < 16)
+    {
+        out.append((char)(fixBase | count));
+    }
+    else if (count <= 0xffff)
+    {
+        out.append((char)code16);
+        out.appendBigEndian(count, 2);
+    }
+    else
+    {
+        out.append((char)code32);
+        out.appendBigEndian(count, 4);
+    }
+}
+
+void encodeObject(const Json::JsonObjectNode& objNode, OutputBuffer& out)
+{
+    encodeContainerHead(objNode.size(), 0x80, 0xde, 0xdf, out);
+    for (const auto& [k, v] : objNode)
+    {
+        encodeString(k, out);
+        MsgPack::encodeValue(v, out);
+    }
+}
+
+void encodeList(const Json::JsonListNode& listNode, OutputBuffer& out)
+{
+    encodeContainerHead(listNode.size(), 0x90, 0xdc, 0xdd, out);
+    for (const auto& v : listNode)
+    {
+        MsgPack::encodeValue(v, out);
+    }
+}
+
+/* Source is utils::ByteReader for in memory data or utils::StreamReader for streams. */
+template <typename Source> class MsgPackDecoder
+{
+public:
+    explicit MsgPackDecoder(Source& inputSource)
+        : source{inputSource}
+    {}
+
+    std::string decodeValue(Json::JsonFieldValue& value, const uint32_t depth)
+    {
+        if (depth > MAX_DEPTH)
+        {
+            return "MessagePack data nested too deep";
+        }
+
+        const uint8_t head = source.read1();
+        if (source.fail())
+        {
+            return "Unexpected end of MessagePack data";
+        }
+
+        if (head <= 0x7f)
+        {
+            value = (int64_t)head;
+        }
+        else if (head >= 0xe0)
+        {
+            value = (int64_t)(int8_t)head;
+        }
+        else if ((head & 0xe0) == 0xa0)
+        {
+            return decodeString(head & 0x1f, value);
+        }
+        else if ((head & 0xf0) == 0x90)
+        {
+            return decodeList(head & 0x0f, value, depth);
+        }
+        else if ((head & 0xf0) == 0x80)
+        {
+            return decodeObject(head & 0x0f, value, depth);
+        }
+        else
+        {
+            switch (head)
+            {
+                case 0xc0:
+                    value = Json::JsonNull{};
+                    break;
+                case 0xc2:
+                    value = false;
+                    break;
+                case 0xc3:
+                    value = true;
+                    break;
+                case 0xcc:
+                    value = (int64_t)source.read1();
+                    break;
+                case 0xcd:
+                    value = (int64_t)source.read2();
+                    break;
+                case 0xce:
+                    value = (int64_t)source.read4();
+                    break;
+                case 0xcf: {
+                    const uint64_t number = source.read8();
+                    if (number > (uint64_t)INT64_MAX)
+                    {
+                        return "MessagePack uint64 value doesn't fit in int64";
+                    }
+                    value = (int64_t)number;
+                    break;
+                }
+                case 0xd0:
+                    value = (int64_t)(int8_t)source.read1();
+                    break;
+                case 0xd1:
+                    value = (int64_t)(int16_t)source.read2();
+                    break;
+                case 0xd2:
+                    value = (int64_t)(int32_t)source.read4();
+                    break;
+                case 0xd3:
+                    value = (int64_t)source.read8();
+                    break;
+                case 0xca:
+                    value = (double)std::bit_cast<float>(source.read4());
+                    break;
+                case 0xcb:
+                    value = std::bit_cast<double>(source.read8());
+                    break;
+                case 0xc4:
+                case 0xd9:
+                    return decodeString(source.read1(), value);
+                case 0xc5:
+                case 0xda:
+                    return decodeString(source.read2(), value);
+                case 0xc6:
+                case 0xdb:
+                    return decodeString(source.read4(), value);
+                case 0xdc:
+                    return decodeList(source.read2(), value, depth);
+                case 0xdd:
+                    return decodeList(source.read4(), value, depth);
+                case 0xde:
+                    return decodeObject(source.read2(), value, depth);
+                case 0xdf:
+                    return decodeObject(source.read4(), value, depth);
+                default: {
+                    std::string errBuff;
+                    sprint(errBuff, "Unsupported MessagePack type 0x%02x", head);
+                    return errBuff;
+                }
+            }
+        }
+
+        if (source.fail())
+        {
+            return "Unexpected end of MessagePack data";
+        }
+        return "";
+    }
+
+private:
+    std::string readString(const uint64_t size, std::string& str)
+    {
+        if (source.fail())
+        {
+            return "Unexpected end of MessagePack data";
+        }
+
+        str = source.readString(size);
+        if (source.fail())
+        {
+            return "Unexpected end of MessagePack data";
+        }
+        return "";
+    }
+
+    std::string decodeString(const uint64_t size, Json::JsonFieldValue& value)
+    {
+        std::string str;
+        std::string error = readString(size, str);
+        value = std::move(str);
+        return error;
+    }
+
+    std::string decodeList(const uint64_t count, Json::JsonFieldValue& value, const uint32_t depth)
+    {
+        if (source.fail())
+        {
+            return "Unexpected end of MessagePack data";
+        }
+
+        Json::JsonListNode listNode;
+        listNode.reserve(std::min(count, MAX_RESERVE));
+        for (uint64_t i{0}; i < count; i++)
+        {
+            Json::JsonFieldValue item;
+            const std::string error = decodeValue(item, depth + 1);
+            if (!error.empty())
+            {
+                return error;
+            }
+            listNode.emplace_back(std::move(item));
+        }
+
+        value = std::move(listNode);
+        return "";
+    }
+
+    std::string decodeObject(const uint64_t count, Json::JsonFieldValue& value, const uint32_t depth)
+    {
+        if (source.fail())
+        {
+            return "Unexpected end of MessagePack data";
+        }
+
+        Json::JsonObjectNode objNode;
+        objNode.reserve(std::min(count, MAX_RESERVE));
+        for (uint64_t i{0}; i < count; i++)
+        {
+            const uint8_t keyHead = source.read1();
+            uint64_t keySize{0};
+            if ((keyHead & 0xe0) == 0xa0)
+            {
+                keySize = keyHead & 0x1f;
+            }
+            else if (keyHead == 0xd9)
+            {
+                keySize = source.read1();
+            }
+            else if (keyHead == 0xda)
+            {
+                keySize = source.read2();
+            }
+            else if (keyHead == 0xdb)
+            {
+                keySize = source.read4();
+            }
+            else
+            {
+                return source.fail() ? "Unexpected end of MessagePack data" : "MessagePack map keys must be strings";
+            }
+
+            std::string key;
+            std::string error = readString(keySize, key);
+            if (!error.empty())
+            {
+                return error;
+            }
+
+            Json::JsonFieldValue item;
+            error = decodeValue(item, depth + 1);
+            if (!error.empty())
+            {
+                return error;
+            }
+            objNode[std::move(key)] = std::move(item);
+        }
+
+        value = std::move(objNode);
+        return "";
+    }
+
+    Source& source;
+};
+template <typename Source> Json::JsonResult decodeRoot(Source& source)
+{
+    Json::JsonFieldValue rootValue;
+    const std::string error = MsgPackDecoder<Source>{source}.decodeValue(rootValue, 0);
+    if (!error.empty())
+    {
+        return {.json = nullptr, .error = error};
+    }
+
+    if (rootValue.isObject())
+    {
+        return {.json = std::make_shared<Json::JsonRootNode>(std::move(rootValue.getObject())), .error = ""};
+    }
+    else if (rootValue.isList())
+    {
+        return {.json = std::make_shared<Json::JsonRootNode>(std::move(rootValue.getList())), .error = ""};
+    }
+    return {.json = nullptr, .error = "MessagePack root must be a map or an array"};
+}
+} // namespace
+
+void MsgPack::encode(const Json::JsonRootNode& root, OutputBuffer& out)
+{
+    if (std::holds_alternative<Json::JsonObjectNode>(root))
+    {
+        encodeObject(std::get<Json::JsonObjectNode>(root), out);
+    }
+    else if (std::holds_alternative<Json::JsonListNode>(root))
+    {
+        encodeList(std::get<Json::JsonListNode>(root), out);
+    }
+}
+
+void MsgPack::encodeValue(const Json::JsonFieldValue& value, OutputBuffer& out)
+{
+    if (value.isString())
+    {
+        encodeString(value.getString(), out);
+    }
+    else if (value.isBool())
+    {
+        out.append((char)(value.getBool() ? 0xc3 : 0xc2));
+    }
+    else if (value.isNull())
+    {
+        out.append((char)0xc0);
+    }
+    else if (value.isInt())
+    {
+        encodeInt(value.getInt(), out);
+    }
+    else if (value.isDouble())
+    {
+        out.append((char)0xcb);
+        out.appendBigEndian(std::bit_cast<uint64_t>(value.getDouble()), 8);
+    }
+    else if (value.isObject())
+    {
+        encodeObject(value.getObject(), out);
+    }
+    else if (value.isList())
+    {
+        encodeList(value.getList(), out);
+    }
+}
+
+Json::JsonResult MsgPack::decode(std::istream& stream)
+{
+    utils::StreamReader source{stream};
+    return decodeRoot(source);
+}
+
+Json::JsonResult MsgPack::decode(utils::ByteReader& reader)
+{
+    return decodeRoot(reader);
+}
+
+} // namespace hk
@@ -0,0 +1,27 @@
+#pragma once
+
+#include "HkJson.hpp"
+#include "OutputBuffer.hpp"
+#include "Utility.hpp"
+
+#include <istream>
+
+namespace hk
+{
+
+/* MessagePack <-> DOM conversion, no JSON text in between.
+    - Integers use the smallest encoding that fits, doubles always go out as float 64.
+    - Decoding accepts float 32 and bin (read back as string); ext types and non string map keys are errors.
+    - decode() consumes exactly one message, so back to back messages can be read from the same stream or reader.
+*/
+class MsgPack
+{
+public:
+    static void encode(const Json::JsonRootNode& root, OutputBuffer& out);
+    static void encodeValue(const Json::JsonFieldValue& value, OutputBuffer& out);
+
+    static Json::JsonResult decode(std::istream& stream);
+    static Json::JsonResult decode(utils::ByteReader& reader);
+};
+
+} // namespace hk
@@ -0,0 +1,80 @@
+#include "OutputBuffer.hpp"
+
+#include "Utility.hpp"
+#include <cerrno>
+#include <cstring>
+#include <unistd.h>
+
+namespace hk
+{
+
+OutputBuffer::OutputBuffer() = default;
+
+OutputBuffer::OutputBuffer(std::string& target)
+    : buffer{&target}
+{}
+
+OutputBuffer::OutputBuffer(const int32_t fileDescriptor, const uint64_t threshold)
+    : fd{fileDescriptor}
+    , flushThreshold{threshold}
+{
+    ownBuffer.reserve(flushThreshold + flushThreshold / 4);
+}
+
+OutputBuffer::~OutputBuffer()
+{
+    flush();
+}
+
+void OutputBuffer::reserve(const uint64_t bytes)
+{
+    buffer->reserve(buffer->size() + bytes);
+}
+
+bool OutputBuffer::flush()
+{
+    if (fd < 0 || buffer->empty())
+    {
+        return error.empty();
+    }
+
+    const char* data = buffer->data();
+    uint64_t left = buffer->size();
+    while (left > 0)
+    {
+        const ssize_t written = ::write(fd, data, left);
+        if (written < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            sprint(error, "Failed to write to fd %d: %s", fd, strerror(errno));
+            break;
+        }
+        data += written;
+        left -= written;
+    }
+
+    buffer->clear();
+    return error.empty();
+}
+
+std::string_view OutputBuffer::view() const
+{
+    return *buffer;
+}
+
+std::string OutputBuffer::take()
+{
+    std::string result = std::move(*buffer);
+    buffer->clear();
+    return result;
+}
+
+const std::string& OutputBuffer::getError() const
+{
+    return error;
+}
+
+} // namespace hk
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace hk
+{
+
+/* Byte sink used by every writer in the library.
+    - Default constructed it owns a growable buffer.
+    - Given a std::string it appends straight into the caller's string.
+    - Given a file descriptor it batches writes and flushes them in large chunks.
+*/
+class OutputBuffer
+{
+public:
+    static constexpr uint64_t DEFAULT_FLUSH_THRESHOLD{256 * 1024};
+
+    OutputBuffer();
+    explicit OutputBuffer(std::string& target);
+    explicit OutputBuffer(const int32_t fd, const uint64_t flushThreshold = DEFAULT_FLUSH_THRESHOLD);
+    ~OutputBuffer();
+
+    OutputBuffer(const OutputBuffer&) = delete;
+    OutputBuffer& operator=(const OutputBuffer&) = delete;
+
+    inline void append(const char* data, const uint64_t size)
+    {
+        buffer->append(data, size);
+        if (fd >= 0 && buffer->size() >= flushThreshold)
+        {
+            flush();
+        }
+    }
+
+    inline void append(const std::string_view data)
+    {
+        append(data.data(), data.size());
+    }
+
+    inline void append(const char ch)
+    {
+        buffer->push_back(ch);
+        if (fd >= 0 && buffer->size() >= flushThreshold)
+        {
+            flush();
+        }
+    }
+
+    /**
+        @brief Append the low _bytes_ bytes of _value_ in big endian order (binary formats).
+    */
+    inline void appendBigEndian(const uint64_t value, const uint32_t bytes)
+    {
+        char tmp[8];
+        for (uint32_t i{0}; i < bytes; i++)
+        {
+            tmp[i] = (char)(value >> ((bytes - 1 - i) * 8));
+        }
+        append(tmp, bytes);
+    }
+
+    /**
+        @brief Make room for _bytes_ more bytes without reallocating on the way.
+    */
+    void reserve(const uint64_t bytes);
+
+    /**
+        @brief Push pending bytes to the file descriptor. No-op for in memory sinks.
+    */
+    bool flush();
+
+    /**
+        @brief Bytes written so far (only meaningful for in memory sinks).
+    */
+    std::string_view view() const;
+
+    /**
+        @brief Move out the owned buffer and leave the sink empty.
+    */
+    std::string take();
+
+    /**
+        @brief Error encountered while flushing, if any. Empty otherwise.
+    */
+    const std::string& getError() const;
+
+private:
+    std::string ownBuffer;
+    std::string* buffer{&ownBuffer};
+    int32_t fd{-1};
+    uint64_t flushThreshold{DEFAULT_FLUSH_THRESHOLD};
+    std::string error;
+};
+
+} // namespace hk
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <cstdint>
+#include <streambuf>
+#include <string_view>
+
+namespace hk
+{
+
+/* Input buffer the parser may scan in place.
+    - String runs are searched with SIMD straight in the get area instead of one sbumpc() at a time.
+    - Only buffers deriving from this one get that fast path, any other streambuf is read through its public
+      interface.
+*/
+class ScanStreamBuf : public std::streambuf
+{
+public:
+    /**
+        @brief Bytes already buffered and not consumed yet, [scanBegin, scanEnd). Empty doesn't mean EOF.
+    */
+    const char* scanBegin() const
+    {
+        return gptr();
+    }
+
+    const char* scanEnd() const
+    {
+        return egptr();
+    }
+
+    /**
+        @brief Consume _count_ bytes of the buffered range.
+    */
+    void consume(const uint32_t count)
+    {
+        gbump((int)count);
+    }
+};
+
+/* Read only buffer over bytes already in memory. Unlike std::istringstream nothing is copied, the bytes must
+   outlive the buffer.
+
+    MemoryStreamBuf buf{data};
+    std::istream stream{&buf};
+*/
+class MemoryStreamBuf : public ScanStreamBuf
+{
+public:
+    explicit MemoryStreamBuf(const std::string_view data)
+    {
+        char* begin = (char*)data.data();
+        setg(begin, begin, begin + data.size());
+    }
+
+protected:
+    pos_type seekoff(off_type off, std::ios_base::seekdir dir, std::ios_base::openmode which) override
+    {
+        if (!(which & std::ios_base::in))
+        {
+            return pos_type(off_type(-1));
+        }
+
+        const off_type origin = dir == std::ios_base::beg ? 0 : (dir == std::ios_base::cur ? gptr() - eback()
+                                                                                              : egptr() - eback());
+        const off_type target = origin + off;
+        if (target < 0 || target > egptr() - eback())
+        {
+            return pos_type(off_type(-1));
+        }
+
+        setg(eback(), eback() + target, egptr());
+        return pos_type(target);
+    }
+
+    pos_type seekpos(pos_type pos, std::ios_base::openmode which) override
+    {
+        return seekoff(off_type(pos), std::ios_base::beg, which);
+    }
+};
+
+} // namespace hk
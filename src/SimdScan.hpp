@@ -0,0 +1,337 @@
+#pragma once
+
+#include <array>
+#include <bit>
+#include <cstdint>
+
+#if defined(__AVX2__) || defined(__SSSE3__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+/* The UTF-8 block check needs SSSE3 (pshufb), which plain x86-64 builds don't enable. Those builds compile it
+   for SSSE3 anyway and only take it after a cpuid check, -mssse3/-march builds call it directly. */
+#if defined(__SSSE3__)
+#define HK_SIMD_SSSE3
+#define HK_SIMD_SSSE3_TARGET
+#elif defined(__SSE2__) && defined(__GNUC__)
+#define HK_SIMD_SSSE3
+#define HK_SIMD_SSSE3_RUNTIME
+#define HK_SIMD_SSSE3_TARGET __attribute__((target("ssse3")))
+#endif
+
+namespace hk
+{
+namespace simd
+{
+
+/* Bytes that can't appear raw inside a JSON string: '"', '\' and control chars. */
+constexpr std::array<bool, 256> NEEDS_ESCAPE = []()
+{
+    std::array<bool, 256> table{};
+    for (uint32_t i{0}; i < 0x20; i++)
+    {
+        table[i] = true;
+    }
+    table['"'] = true;
+    table['\\'] = true;
+    return table;
+}();
+
+/**
+    @brief Index of the first byte in _data_ that needs escaping when written as a JSON string, _size_ if none.
+*/
+inline uint64_t findEscapable(const char* data, const uint64_t size)
+{
+    uint64_t i{0};
+
+#if defined(__AVX2__)
+    const __m256i quote32 = _mm256_set1_epi8('"');
+    const __m256i backslash32 = _mm256_set1_epi8('\\');
+    const __m256i ctrlMax32 = _mm256_set1_epi8(0x1f);
+    for (; i + 32 <= size; i += 32)
+    {
+        const __m256i chunk = _mm256_loadu_si256((const __m256i*)(data + i));
+        /* min(x, 0x1f) == x  <=>  x <= 0x1f when compared unsigned */
+        const __m256i isCtrl = _mm256_cmpeq_epi8(_mm256_min_epu8(chunk, ctrlMax32), chunk);
+        const __m256i hits = _mm256_or_si256(
+            _mm256_or_si256(_mm256_cmpeq_epi8(chunk, quote32), _mm256_cmpeq_epi8(chunk, backslash32)), isCtrl);
+        const uint32_t mask = _mm256_movemask_epi8(hits);
+        if (mask != 0)
+        {
+            return i + std::countr_zero(mask);
+        }
+    }
+#endif
+
+#if defined(__SSE2__)
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    const __m128i ctrlMax = _mm_set1_epi8(0x1f);
+    for (; i + 16 <= size; i += 16)
+    {
+        const __m128i chunk = _mm_loadu_si128((const __m128i*)(data + i));
+        const __m128i isCtrl = _mm_cmpeq_epi8(_mm_min_epu8(chunk, ctrlMax), chunk);
+        const __m128i hits =
+            _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(chunk, quote), _mm_cmpeq_epi8(chunk, backslash)), isCtrl);
+        const uint32_t mask = _mm_movemask_epi8(hits);
+        if (mask != 0)
+        {
+            return i + std::countr_zero(mask);
+        }
+    }
+#endif
+
+    for (; i < size; i++)
+    {
+        if (NEEDS_ESCAPE[(uint8_t)data[i]])
+        {
+            return i;
+        }
+    }
+    return size;
+}
+
+/**
+    @brief Index of the first byte in _data_ that isn't JSON whitespace (space, \t, \n, \r), _size_ if none.
+*/
+inline uint64_t findNonWhitespace(const char* data, const uint64_t size)
+{
+    uint64_t i{0};
+
+#if defined(__SSE2__)
+    const __m128i space = _mm_set1_epi8(' ');
+    const __m128i tab = _mm_set1_epi8('\t');
+    const __m128i newline = _mm_set1_epi8('\n');
+    const __m128i carriageReturn = _mm_set1_epi8('\r');
+    for (; i + 16 <= size; i += 16)
+    {
+        const __m128i chunk = _mm_loadu_si128((const __m128i*)(data + i));
+        const __m128i isSpace =
+            _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(chunk, space), _mm_cmpeq_epi8(chunk, tab)),
+                _mm_or_si128(_mm_cmpeq_epi8(chunk, newline), _mm_cmpeq_epi8(chunk, carriageReturn)));
+        const uint32_t mask = ~_mm_movemask_epi8(isSpace) & 0xffff;
+        if (mask != 0)
+        {
+            return i + std::countr_zero(mask);
+        }
+    }
+#endif
+
+    for (; i < size; i++)
+    {
+        if (data[i] != ' ' && data[i] != '\t' && data[i] != '\n' && data[i] != '\r')
+        {
+            return i;
+        }
+    }
+    return size;
+}
+
+/**
+    @brief Validate UTF-8 one sequence at a time starting at _i_, until _i_ reaches _stopAt_ (sequences may run
+        past it, up to _size_). On an invalid sequence _i_ is left on its first byte and false is returned.
+*/
+constexpr bool scanUtf8(const char* data, const uint64_t size, uint64_t& i, const uint64_t stopAt)
+{
+    while (i < stopAt)
+    {
+        const uint8_t lead = data[i];
+        if (lead < 0x80)
+        {
+            i++;
+            continue;
+        }
+
+        /* Ranges per RFC 3629: no overlongs, no surrogates, nothing above U+10FFFF. */
+        uint64_t length{0};
+        uint8_t secondMin{0x80};
+        uint8_t secondMax{0xbf};
+        if (lead >= 0xc2 && lead <= 0xdf)
+        {
+            length = 2;
+        }
+        else if (lead >= 0xe0 && lead <= 0xef)
+        {
+            length = 3;
+            secondMin = lead == 0xe0 ? 0xa0 : 0x80;
+            secondMax = lead == 0xed ? 0x9f : 0xbf;
+        }
+        else if (lead >= 0xf0 && lead <= 0xf4)
+        {
+            length = 4;
+            secondMin = lead == 0xf0 ? 0x90 : 0x80;
+            secondMax = lead == 0xf4 ? 0x8f : 0xbf;
+        }
+        else
+        {
+            return false;
+        }
+
+        if (i + length > size || (uint8_t)data[i + 1] < secondMin || (uint8_t)data[i + 1] > secondMax)
+        {
+            return false;
+        }
+        for (uint64_t k{2}; k < length; k++)
+        {
+            if (((uint8_t)data[i + k] & 0xc0) != 0x80)
+            {
+                return false;
+            }
+        }
+        i += length;
+    }
+    return true;
+}
+
+#if defined(HK_SIMD_SSSE3)
+/**
+    @brief Keiser-Lemire block check: three nibble lookups classify every (previous byte, byte) pair, the
+        result is non zero if any sequence ending in or crossing into _input_ is invalid.
+*/
+HK_SIMD_SSSE3_TARGET inline __m128i utf8BlockErrors(const __m128i input, const __m128i prev)
+{
+    constexpr uint8_t TOO_SHORT = 1 << 0;
+    constexpr uint8_t TOO_LONG = 1 << 1;
+    constexpr uint8_t OVERLONG_3 = 1 << 2;
+    constexpr uint8_t TOO_LARGE = 1 << 3;
+    constexpr uint8_t SURROGATE = 1 << 4;
+    constexpr uint8_t OVERLONG_2 = 1 << 5;
+    constexpr uint8_t TOO_LARGE_1000 = 1 << 6;
+    constexpr uint8_t OVERLONG_4 = 1 << 6;
+    constexpr uint8_t TWO_CONTS = 1 << 7;
+    constexpr uint8_t CARRY = TOO_SHORT | TOO_LONG | TWO_CONTS;
+
+    const __m128i byte1HighTable = _mm_setr_epi8(TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG,
+        TOO_LONG, TOO_LONG, TWO_CONTS, TWO_CONTS, TWO_CONTS, TWO_CONTS, TOO_SHORT | OVERLONG_2, TOO_SHORT,
+        TOO_SHORT | OVERLONG_3 | SURROGATE, TOO_SHORT | TOO_LARGE | TOO_LARGE_1000 | OVERLONG_4);
+    const __m128i byte1LowTable = _mm_setr_epi8(CARRY | OVERLONG_3 | OVERLONG_2 | OVERLONG_4, CARRY | OVERLONG_2,
+        CARRY, CARRY, CARRY | TOO_LARGE, CARRY | TOO_LARGE | TOO_LARGE_1000, CARRY | TOO_LARGE | TOO_LARGE_1000,
+        CARRY | TOO_LARGE | TOO_LARGE_1000, CARRY | TOO_LARGE | TOO_LARGE_1000, CARRY | TOO_LARGE | TOO_LARGE_1000,
+        CARRY | TOO_LARGE | TOO_LARGE_1000, CARRY | TOO_LARGE | TOO_LARGE_1000, CARRY | TOO_LARGE | TOO_LARGE_1000,
+        CARRY | TOO_LARGE | TOO_LARGE_1000 | SURROGATE, CARRY | TOO_LARGE | TOO_LARGE_1000,
+        CARRY | TOO_LARGE | TOO_LARGE_1000);
+    const __m128i byte2HighTable = _mm_setr_epi8(TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT,
+        TOO_SHORT, TOO_SHORT, TOO_LONG | OVERLONG_2 | TWO_CONTS | OVERLONG_3 | TOO_LARGE_1000 | OVERLONG_4,
+        TOO_LONG | OVERLONG_2 | TWO_CONTS | OVERLONG_3 | TOO_LARGE,
+        TOO_LONG | OVERLONG_2 | TWO_CONTS | SURROGATE | TOO_LARGE,
+        TOO_LONG | OVERLONG_2 | TWO_CONTS | SURROGATE | TOO_LARGE, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT);
+
+    const __m128i lowNibble = _mm_set1_epi8(0x0f);
+    const __m128i prev1 = _mm_alignr_epi8(input, prev, 15);
+    const __m128i byte1High =
+        _mm_shuffle_epi8(byte1HighTable, _mm_and_si128(_mm_srli_epi16(prev1, 4), lowNibble));
+    const __m128i byte1Low = _mm_shuffle_epi8(byte1LowTable, _mm_and_si128(prev1, lowNibble));
+    const __m128i byte2High =
+        _mm_shuffle_epi8(byte2HighTable, _mm_and_si128(_mm_srli_epi16(input, 4), lowNibble));
+    const __m128i special = _mm_and_si128(_mm_and_si128(byte1High, byte1Low), byte2High);
+
+    /* 3rd/4th bytes of 3/4 byte sequences must be continuations, the lookups above can't see that far back. */
+    const __m128i isThird = _mm_subs_epu8(_mm_alignr_epi8(input, prev, 14), _mm_set1_epi8((char)(0xe0 - 0x80)));
+    const __m128i isFourth = _mm_subs_epu8(_mm_alignr_epi8(input, prev, 13), _mm_set1_epi8((char)(0xf0 - 0x80)));
+    const __m128i must23 = _mm_and_si128(_mm_or_si128(isThird, isFourth), _mm_set1_epi8((char)0x80));
+    return _mm_xor_si128(must23, special);
+}
+#endif
+
+/**
+    @brief Start of the UTF-8 sequence that contains or ends right before _i_ (at most 3 bytes back).
+*/
+inline uint64_t utf8SequenceStart(const char* data, const uint64_t i)
+{
+    for (uint64_t k{1}; k <= 3 && k <= i; k++)
+    {
+        const uint8_t byte = data[i - k];
+        if (byte >= 0xc0)
+        {
+            return i - k;
+        }
+        if (byte < 0x80)
+        {
+            break;
+        }
+    }
+    return i;
+}
+
+#if defined(HK_SIMD_SSSE3)
+/**
+    @brief True if the CPU running us has SSSE3, checked once.
+*/
+inline bool hasSsse3()
+{
+#if defined(HK_SIMD_SSSE3_RUNTIME)
+    static const bool supported = []()
+    {
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("ssse3") != 0;
+    }();
+    return supported;
+#else
+    return true;
+#endif
+}
+
+/**
+    @brief findInvalidUtf8 with 16 byte blocks checked by utf8BlockErrors, ASCII blocks skipped.
+*/
+HK_SIMD_SSSE3_TARGET inline uint64_t findInvalidUtf8Ssse3(const char* data, const uint64_t size)
+{
+    uint64_t i{0};
+    __m128i prev = _mm_setzero_si128();
+    bool prevAscii{true};
+    for (; i + 16 <= size; i += 16)
+    {
+        const __m128i chunk = _mm_loadu_si128((const __m128i*)(data + i));
+        const bool ascii = _mm_movemask_epi8(chunk) == 0;
+        if (!(ascii && prevAscii))
+        {
+            const __m128i errors = utf8BlockErrors(chunk, prev);
+            if (_mm_movemask_epi8(_mm_cmpeq_epi8(errors, _mm_setzero_si128())) != 0xffff)
+            {
+                /* Everything before the last sequence start is known good, a scalar walk pins the exact byte. */
+                i = utf8SequenceStart(data, i);
+                scanUtf8(data, size, i, size);
+                return i;
+            }
+        }
+        prev = chunk;
+        prevAscii = ascii;
+    }
+    i = utf8SequenceStart(data, i);
+    return scanUtf8(data, size, i, size) ? size : i;
+}
+#endif
+
+/**
+    @brief Offset of the first byte of the first invalid UTF-8 sequence in _data_, _size_ if all of it is valid.
+*/
+inline uint64_t findInvalidUtf8(const char* data, const uint64_t size)
+{
+#if defined(HK_SIMD_SSSE3)
+    if (hasSsse3())
+    {
+        return findInvalidUtf8Ssse3(data, size);
+    }
+#endif
+
+    uint64_t i{0};
+#if defined(__SSE2__)
+    while (i + 16 <= size)
+    {
+        const __m128i chunk = _mm_loadu_si128((const __m128i*)(data + i));
+        if (_mm_movemask_epi8(chunk) == 0)
+        {
+            i += 16;
+        }
+        else if (!scanUtf8(data, size, i, i + 16))
+        {
+            return i;
+        }
+    }
+#endif
+
+    return scanUtf8(data, size, i, size) ? size : i;
+}
+
+} // namespace simd
+} // namespace hk
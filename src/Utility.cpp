@@ -1,4 +1,5 @@
 #include "Utility.hpp"
+#include <algorithm>
 #include <cstdint>
 #include <cstdio>
 
@@ -41,26 +42,38 @@ uint32_t read4(std::istream& stream)
 
 uint64_t read8(std::istream& stream)
 {
-    // promote to 64 directly as we will hold in it final result
-    uint64_t high = read4(stream);
-    uint32_t low = read4(stream);
+    uint8_t tmp[8];
+    stream.read((char*)tmp, 8);
 
-    return high << 32 | low;
+    return loadBigEndian<uint64_t>(tmp);
 }
 
-std::vector<uint8_t> readBytes(std::istream& stream, uint32_t n)
+std::vector<uint8_t> readBytes(std::istream& stream, uint64_t n)
 {
-    std::vector<uint8_t> result(n, '\0');
-
-    stream.read((char*)result.data(), n);
+    std::vector<uint8_t> result;
+
+    // n comes from the input: no reserve(n), grow with what actually arrives so a lying length can't
+    // make us allocate gigabytes up front
+    uint8_t chunk[4096];
+    while (n > 0 && stream.read((char*)chunk, std::min<uint64_t>(n, sizeof(chunk))).gcount() > 0)
+    {
+        result.insert(result.end(), chunk, chunk + stream.gcount());
+        n -= stream.gcount();
+    }
     return result;
 }
 
-std::string readStringBytes(std::istream& stream, uint32_t n)
+std::string readStringBytes(std::istream& stream, uint64_t n)
 {
-    std::string result(n, '\0');
-
-    stream.read(result.data(), n);
+    std::string result;
+
+    // n comes from the input: grow with what actually arrives, a lying length stops at end of stream
+    char chunk[4096];
+    while (n > 0 && stream.read(chunk, std::min<uint64_t>(n, sizeof(chunk))).gcount() > 0)
+    {
+        result.append(chunk, stream.gcount());
+        n -= stream.gcount();
+    }
     return result;
 }
 
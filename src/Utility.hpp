@@ -1,8 +1,13 @@
 #pragma once
 
+#include <bit>
 #include <cstdint>
 #include <cstdio>
+#include <cstring>
 #include <fstream>
+#include <span>
+#include <string>
+#include <string_view>
 #include <vector>
 
 // Surely std::format could be used but if utility is included across multiple translation units
@@ -100,17 +105,227 @@ uint64_t read8(std::istream& stream);
 /**
     @brief Read N bytes and return the vector it forms
 */
-std::vector<uint8_t> readBytes(std::istream& stream, uint32_t n);
+std::vector<uint8_t> readBytes(std::istream& stream, uint64_t n);
 
 /**
     @brief Read N bytes, supposedly ASCII and return the string it forms
 */
-std::string readStringBytes(std::istream& stream, uint32_t n);
+std::string readStringBytes(std::istream& stream, uint64_t n);
 
 /**
     @brief Determine if the next 12 bytes form the magic number
 */
 bool isMagicNumberNext(std::istream& stream);
 
+/**
+    @brief Unaligned load of a big endian T from _ptr_. No bounds checks.
+*/
+template <typename T> inline T loadBigEndian(const uint8_t* ptr)
+{
+    T value;
+    memcpy(&value, ptr, sizeof(T));
+    if constexpr (std::endian::native == std::endian::little && sizeof(T) > 1)
+    {
+        value = std::byteswap(value);
+    }
+    return value;
+}
+
+/**
+    @brief Unaligned store of _value_ as big endian into _ptr_. No bounds checks.
+*/
+template <typename T> inline void storeBigEndian(uint8_t* ptr, T value)
+{
+    if constexpr (std::endian::native == std::endian::little && sizeof(T) > 1)
+    {
+        value = std::byteswap(value);
+    }
+    memcpy(ptr, &value, sizeof(T));
+}
+
+/**
+    @brief Cursor over an in memory byte span, the fast counterpart of the istream helpers above.
+    Reads are bounds checked. Reading past the end returns 0 and latches fail(), like a stream would.
+    Bulk reads hand out views into the span or construct the result straight from it (no zero fill).
+*/
+class ByteReader
+{
+public:
+    explicit ByteReader(const std::span<const uint8_t> bytes)
+        : cursor{bytes.data()}
+        , begin{bytes.data()}
+        , end{bytes.data() + bytes.size()}
+    {}
+
+    ByteReader(const void* data, const uint64_t size)
+        : ByteReader(std::span<const uint8_t>{(const uint8_t*)data, size})
+    {}
+
+    bool fail() const
+    {
+        return failed;
+    }
+
+    bool isEOF() const
+    {
+        return cursor == end;
+    }
+
+    uint64_t remaining() const
+    {
+        return end - cursor;
+    }
+
+    uint64_t position() const
+    {
+        return cursor - begin;
+    }
+
+    /**
+        @brief Next byte without consuming it, -1 at the end.
+    */
+    int32_t peek() const
+    {
+        return cursor < end ? *cursor : -1;
+    }
+
+    uint8_t read1()
+    {
+        return readBigEndian<uint8_t>();
+    }
+
+    uint16_t read2()
+    {
+        return readBigEndian<uint16_t>();
+    }
+
+    uint32_t read4()
+    {
+        return readBigEndian<uint32_t>();
+    }
+
+    uint64_t read8()
+    {
+        return readBigEndian<uint64_t>();
+    }
+
+    /**
+        @brief View of the next _n_ bytes, empty (and fail()) if there aren't that many.
+    */
+    std::span<const uint8_t> readSpan(const uint64_t n)
+    {
+        if (!ensure(n))
+        {
+            return {};
+        }
+        const std::span<const uint8_t> result{cursor, n};
+        cursor += n;
+        return result;
+    }
+
+    std::string_view readStringView(const uint64_t n)
+    {
+        const std::span<const uint8_t> bytes = readSpan(n);
+        return {(const char*)bytes.data(), bytes.size()};
+    }
+
+    std::string readString(const uint64_t n)
+    {
+        return std::string{readStringView(n)};
+    }
+
+    bool readInto(void* destination, const uint64_t n)
+    {
+        const std::span<const uint8_t> bytes = readSpan(n);
+        if (!bytes.empty())
+        {
+            memcpy(destination, bytes.data(), n);
+        }
+        return !failed;
+    }
+
+    bool skip(const uint64_t n)
+    {
+        return readSpan(n).size() == n;
+    }
+
+private:
+    bool ensure(const uint64_t n)
+    {
+        if ((uint64_t)(end - cursor) < n)
+        {
+            failed = true;
+            cursor = end;
+            return false;
+        }
+        return true;
+    }
+
+    template <typename T> T readBigEndian()
+    {
+        if (!ensure(sizeof(T)))
+        {
+            return 0;
+        }
+        const T value = loadBigEndian<T>(cursor);
+        cursor += sizeof(T);
+        return value;
+    }
+
+    const uint8_t* cursor;
+    const uint8_t* begin;
+    const uint8_t* end;
+    bool failed{false};
+};
+
+/**
+    @brief ByteReader's interface on top of the istream helpers, for decoders templated on their input.
+*/
+class StreamReader
+{
+public:
+    explicit StreamReader(std::istream& inputStream)
+        : stream{inputStream}
+    {}
+
+    bool fail() const
+    {
+        return stream.fail();
+    }
+
+    int32_t peek()
+    {
+        return stream.peek();
+    }
+
+    uint8_t read1()
+    {
+        return utils::read1(stream);
+    }
+
+    uint16_t read2()
+    {
+        return utils::read2(stream);
+    }
+
+    uint32_t read4()
+    {
+        return utils::read4(stream);
+    }
+
+    uint64_t read8()
+    {
+        return utils::read8(stream);
+    }
+
+    std::string readString(const uint64_t n)
+    {
+        return utils::readStringBytes(stream, n);
+    }
+
+private:
+    std::istream& stream;
+};
+
 } // namespace utils
 
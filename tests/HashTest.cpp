@@ -0,0 +1,75 @@
+#include "src/HkJson.hpp"
+#include "src/Utility.hpp"
+
+#include <functional>
+
+using namespace hk;
+
+namespace
+{
+uint32_t failures{0};
+
+void check(const bool condition, const char* what)
+{
+    if (!condition)
+    {
+        printlne("FAILED: %s", what);
+        failures++;
+    }
+}
+
+Json::JsonResult load(const std::string& source)
+{
+    Json json;
+    return json.loadFromString(source);
+}
+} // namespace
+
+int main(int, char**)
+{
+    Json::JsonResult edited = load(R"({"x": {"y": 1}, "list": [1, 2]})");
+    Json::JsonResult original = load(R"({"x": {"y": 1}, "list": [1, 2]})");
+    if (!edited.error.empty() || !original.error.empty())
+    {
+        printlne("%s%s", edited.error.c_str(), original.error.c_str());
+        return 1;
+    }
+
+    Json::JsonRootNode& root = *edited.json;
+    Json::JsonRootNode& copy = *original.json;
+
+    /* References taken before hashing, then edited behind the hash's back. */
+    Json::JsonFieldValue& x = root["x"];
+    Json::JsonListNode& list = root["list"].getList();
+    const uint64_t before = Json::hashValue(root);
+    check(before == Json::hashValue(copy), "equal documents hash the same");
+    check(Json::diff(root, copy).empty(), "equal documents give an empty diff");
+
+    x["y"] = 2;
+    check(Json::hashValue(root) != before, "hash follows an edit through a kept reference");
+    check(Json::hashValue(root) != Json::hashValue(copy), "edited and original hashes differ");
+    check(!Json::valuesEqual(root["x"], copy.getObject().at("x")), "valuesEqual sees the edit");
+    check(std::hash<Json::JsonFieldValue>{}(root["x"]) != std::hash<Json::JsonFieldValue>{}(copy.getObject().at("x")),
+        "std::hash sees the edit");
+    check(Json::diff(copy, root).size() == 1, "diff reports the edit");
+
+    x["y"] = 1;
+    list.push_back(Json::JsonFieldValue{(int64_t)3});
+    check(Json::diff(copy, root).size() == 1, "diff reports an edit made through the std::vector API");
+
+    /* The opt-in cache only knows what it has seen, clearing it picks edits up again. */
+    Json::HashCache hashes;
+    list.pop_back();
+    check(hashes.hash(root) == hashes.hash(copy), "cache hashes equal documents the same");
+    x["y"] = 3;
+    hashes.clear();
+    check(hashes.hash(root) != hashes.hash(copy), "cleared cache sees the edit");
+    check(hashes.hash(root) == Json::hashValue(root), "cache and hashValue agree");
+
+    if (failures != 0)
+    {
+        return 1;
+    }
+    println("hash_test passed");
+    return 0;
+}